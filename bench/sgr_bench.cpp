@@ -0,0 +1,569 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "CSIScanner.h"
+#include "CheckpointIndex.h"
+#include "ColorQuantizer.h"
+#include "HTMLRenderer.h"
+#include "IncrementalDocument.h"
+#include "SGREncoder.h"
+#include "SGRParser.h"
+#include "SGRPipeline.h"
+#include "SGRStreamParser.h"
+#include "Scrollback.h"
+#include "TextParser.h"
+
+using namespace ANSI;
+
+static const TextAttribute defaultAttr { TextAttribute::State::DEFAULT, { { 0, 0, 0 }, { 255, 255, 255 } } };
+
+struct Corpus {
+    std::string              name;
+    std::vector<std::string> lines;
+    std::string              joined;    // lines joined by '\n', input of stream parser
+    std::vector<std::string> sequences; // all SGR sequences of the lines
+};
+
+struct Result {
+    std::string corpus;
+    std::string bench;
+    size_t      bytes;
+    size_t      sequences;
+    double      seconds; // best of all iterations
+};
+
+struct Options {
+    size_t      corpusBytes = 8 << 20;
+    int         iterations  = 5;
+    std::string format      = "csv";
+};
+
+// keep results alive, so the compiler can not drop the measured work
+static volatile size_t sink;
+
+class CorpusGenerator {
+public:
+    explicit CorpusGenerator(size_t bytes)
+        : bytes_(bytes)
+        , random_(20231017)
+    {
+    }
+
+    // plain text without any escape sequence
+    Corpus plain()
+    {
+        return make("plain", [this](std::string& line) {
+            while (line.size() < 80) {
+                line += word();
+                line += ' ';
+            }
+        });
+    }
+
+    // a few 4-bit colored words per hundred lines
+    Corpus sparse4Bit()
+    {
+        return make("sparse_4bit", [this](std::string& line) {
+            while (line.size() < 80) {
+                if (uniform(0, 200) == 0) {
+                    line += "\033[" + std::to_string(uniform(30, 37)) + "m" + word() + "\033[0m ";
+                }
+                else {
+                    line += word() + ' ';
+                }
+            }
+        });
+    }
+
+    // every word has its own 8-bit or 24-bit color, like color.txt
+    Corpus dense()
+    {
+        return make("dense_8_24bit", [this](std::string& line) {
+            while (line.size() < 200) {
+                if (uniform(0, 1) == 0) {
+                    line += "\033[1;38;5;" + std::to_string(uniform(0, 255)) + "m";
+                }
+                else {
+                    line += "\033[38;2;" + std::to_string(uniform(0, 255)) + ";" + std::to_string(uniform(0, 255))
+                        + ";" + std::to_string(uniform(0, 255)) + ";48;5;" + std::to_string(uniform(0, 255)) + "m";
+                }
+                line += word();
+                line += "\033[0m ";
+            }
+        });
+    }
+
+    // gcc/clang colored diagnostics
+    Corpus diagnostics()
+    {
+        return make("diagnostics", [this](std::string& line) {
+            switch (uniform(0, 3)) {
+            case 0: {
+                line += "\033[01m\033[Ksrc/" + word() + ".cpp:" + std::to_string(uniform(1, 999)) + ":"
+                    + std::to_string(uniform(1, 80)) + ":\033[m\033[K \033[01;31m\033[Kerror: \033[m\033[K'" + word()
+                    + "' was not declared in this scope";
+            } break;
+            case 1: {
+                line += "\033[01m\033[Ksrc/" + word() + ".h:" + std::to_string(uniform(1, 999))
+                    + ":\033[m\033[K \033[01;35m\033[Kwarning: \033[m\033[Kunused variable '\033[01m\033[K" + word()
+                    + "\033[m\033[K' [\033[01;35m\033[K-Wunused-variable\033[m\033[K]";
+            } break;
+            case 2: {
+                line += "  " + std::to_string(uniform(1, 999)) + " |     \033[01;31m\033[K" + word() + "\033[m\033[K("
+                    + word() + ");";
+            } break;
+            default: {
+                line += "      |     \033[01;32m\033[K^~~~~~\033[m\033[K";
+            } break;
+            }
+        });
+    }
+
+    // truncated sequences, invalid bytes and oversized parameters
+    Corpus malformed()
+    {
+        return make("malformed", [this](std::string& line) {
+            while (line.size() < 100) {
+                switch (uniform(0, 5)) {
+                case 0:
+                    line += "\033[31";
+                    break;
+                case 1:
+                    line += "\033[38;5;999m";
+                    break;
+                case 2:
+                    line += "\033[1;2\x01m";
+                    break;
+                case 3:
+                    line += "\033x\033";
+                    break;
+                case 4:
+                    line += "\033[38;2;1;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;m";
+                    break;
+                default:
+                    line += word() + ' ';
+                    break;
+                }
+            }
+        });
+    }
+
+    // non-ASCII text: CJK, accented letters and emoji with sparse colors
+    Corpus unicode()
+    {
+        static const char* const words[] { "日志", "错误", "警告", "完成", "café", "naïve", "Größe", "🚀", "✅" };
+        return make("unicode", [this](std::string& line) {
+            while (line.size() < 160) {
+                if (uniform(0, 7) == 0) {
+                    line += "\033[" + std::to_string(uniform(31, 37)) + "m" + words[uniform(0, 8)] + "\033[0m ";
+                }
+                else {
+                    line += uniform(0, 1) == 0 ? word() : words[uniform(0, 8)];
+                    line += ' ';
+                }
+            }
+        });
+    }
+
+private:
+    template <typename MakeLine>
+    Corpus make(std::string name, MakeLine&& makeLine)
+    {
+        Corpus corpus { std::move(name), {}, {}, {} };
+        size_t bytes = 0;
+        while (bytes < bytes_) {
+            std::string line;
+            makeLine(line);
+            bytes += line.size() + 1;
+            corpus.lines.emplace_back(std::move(line));
+        }
+
+        for (const auto& line : corpus.lines) {
+            corpus.joined += line;
+            corpus.joined += '\n';
+
+            std::string text;
+            for (const auto& seq : CSIScanner::scan(line, text)) {
+                if (seq.finalByte() == CSIFinalBytes::SGR) {
+                    corpus.sequences.emplace_back(seq.sequence);
+                }
+            }
+        }
+        return corpus;
+    }
+
+    int uniform(int min, int max) { return std::uniform_int_distribution<int>(min, max)(random_); }
+
+    std::string word()
+    {
+        std::string word(uniform(2, 10), ' ');
+        for (auto& ch : word) {
+            ch = char('a' + uniform(0, 25));
+        }
+        return word;
+    }
+
+private:
+    size_t       bytes_;
+    std::mt19937 random_;
+};
+
+static double measure(int iterations, const std::function<void()>& func)
+{
+    double best = 0;
+    for (int i = 0; i < iterations; ++i) {
+        auto begin = std::chrono::steady_clock::now();
+        func();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+        if (i == 0 || elapsed.count() < best) {
+            best = elapsed.count();
+        }
+    }
+    return best;
+}
+
+static void runCorpus(const Corpus& corpus, const Options& options, std::vector<Result>& results)
+{
+    size_t seqBytes = 0;
+    for (const auto& seq : corpus.sequences) {
+        seqBytes += seq.size();
+    }
+    const size_t bytes   = corpus.joined.size();
+    const size_t seqCnt  = corpus.sequences.size();
+    auto         addBest = [&](const char* bench, size_t benchBytes, const std::function<void()>& func) {
+        results.push_back({ corpus.name, bench, benchBytes, seqCnt, measure(options.iterations, func) });
+    };
+
+    addBest("CSIScanner::scan", bytes, [&] {
+        std::string              text;
+        std::vector<CSISequence> seqs;
+        for (const auto& line : corpus.lines) {
+            text.clear();
+            seqs.clear();
+            CSIScanner::scan(line, text, seqs);
+        }
+        sink = text.size() + seqs.size();
+    });
+
+    // memory bandwidth reference of strip
+    addBest("memcpy", bytes, [&] {
+        std::string text(corpus.joined.size(), '\0');
+        std::memcpy(text.data(), corpus.joined.data(), corpus.joined.size());
+        sink = text.size();
+    });
+
+    addBest("CSIScanner::strip", bytes, [&] {
+        std::string text;
+        CSIScanner::strip(corpus.joined, text);
+        sink = text.size();
+    });
+
+    addBest("CSIScanner::strip(in place)", bytes, [&] {
+        std::string text = corpus.joined;
+        CSIScanner::strip(text);
+        sink = text.size();
+    });
+
+    addBest("SGRParser::parseSGRSequence", seqBytes, [&] {
+        SGRParser     parser(defaultAttr);
+        TextAttribute attr = defaultAttr;
+        for (const auto& seq : corpus.sequences) {
+            attr = parser.parseSGRSequence(attr, seq).second;
+        }
+        sink = attr.color.front.r;
+    });
+
+    addBest("SGRParseCore::parse", seqBytes, [&] {
+        size_t results = 0;
+        for (const auto& seq : corpus.sequences) {
+            SGRParseCore     core;
+            std::string_view view(seq);
+            view.remove_prefix(HEAD_CNT);
+            while (!view.empty()) {
+                core.parse(view);
+                results += size_t(core.result());
+                core.reset();
+            }
+        }
+        sink = results;
+    });
+
+    addBest("TextParser::parse", bytes, [&] {
+        TextParser parser(defaultAttr, defaultAttr);
+        auto       textList = parser.parse(corpus.lines);
+        sink                = textList.size();
+    });
+
+    addBest("TextParser::parseColumns", bytes, [&] {
+        TextParser parser(defaultAttr, defaultAttr);
+        size_t     columns = 0;
+        for (const auto& line : corpus.lines) {
+            auto columnText = parser.parseColumns(line);
+            columns += columnText.columns.empty() ? 0 : columnText.columns.back().columnLen;
+        }
+        sink = columns;
+    });
+
+    addBest("TextParser::parse(no coalesce)", bytes, [&] {
+        TextParser parser(defaultAttr, defaultAttr);
+        parser.enableCoalesce(false);
+        auto textList = parser.parse(corpus.lines);
+        sink          = textList.size();
+    });
+
+    // one request is 256 lines, its results are freed before the next one
+    constexpr size_t requestLines = 256;
+    addBest("TextParser::parse(request)", bytes, [&] {
+        TextParser parser(defaultAttr, defaultAttr);
+        size_t     textCnt = 0;
+        for (size_t begin = 0; begin < corpus.lines.size(); begin += requestLines) {
+            size_t end = std::min(begin + requestLines, corpus.lines.size());
+            for (size_t i = begin; i < end; ++i) {
+                textCnt += parser.parse(corpus.lines[i]).color.size();
+            }
+        }
+        sink = textCnt;
+    });
+
+    addBest("TextParser::parse(request pmr)", bytes, [&] {
+        TextParser                          parser(defaultAttr, defaultAttr);
+        std::vector<char>                   arena(1 << 20);
+        std::pmr::monotonic_buffer_resource resource(arena.data(), arena.size());
+        size_t                              textCnt = 0;
+        for (size_t begin = 0; begin < corpus.lines.size(); begin += requestLines) {
+            size_t end = std::min(begin + requestLines, corpus.lines.size());
+            for (size_t i = begin; i < end; ++i) {
+                textCnt += parser.parse(corpus.lines[i], &resource).color.size();
+            }
+            resource.release();
+        }
+        sink = textCnt;
+    });
+
+    addBest("TextParser::parse(buffer)", bytes, [&] {
+        TextParser         parser(defaultAttr, defaultAttr);
+        ColorfulTextBuffer buffer;
+        for (const auto& line : corpus.lines) {
+            parser.parse(line, buffer);
+        }
+        sink = buffer.size();
+    });
+
+    addBest("TextParser::visit", bytes, [&] {
+        struct Visitor {
+            size_t textBytes = 0;
+            size_t changes   = 0;
+
+            void onText(std::string_view text, const TextAttribute&) { textBytes += text.size(); }
+            void onAttrChange(const TextAttribute&, const TextAttribute&) { ++changes; }
+        } visitor;
+
+        TextParser parser(defaultAttr, defaultAttr);
+        for (const auto& line : corpus.lines) {
+            parser.visit(line, visitor);
+        }
+        sink = visitor.textBytes + visitor.changes;
+    });
+
+    addBest("TextParser::parseParallel", bytes, [&] {
+        TextParser parser(defaultAttr, defaultAttr);
+        auto       textList = parser.parseParallel(corpus.lines);
+        sink                = textList.size();
+    });
+
+    addBest("SGRStreamParser::parse", bytes, [&] {
+        constexpr size_t chunkSize = 4096;
+        SGRStreamParser  parser(defaultAttr, defaultAttr);
+        size_t           textBytes = 0;
+        auto             onText    = [&textBytes](std::string_view text, const TextAttribute&) {
+            textBytes += text.size();
+        };
+        for (size_t pos = 0; pos < corpus.joined.size(); pos += chunkSize) {
+            parser.parse(std::string_view(corpus.joined).substr(pos, chunkSize), onText);
+        }
+        parser.finish(onText);
+        sink = textBytes;
+    });
+
+    // re-encode parsed lines, bytes is the size of the source
+    AttributeTable           table;
+    std::vector<CompactText> compactLines;
+    {
+        TextParser parser(defaultAttr, defaultAttr);
+        compactLines.reserve(corpus.lines.size());
+        for (const auto& line : corpus.lines) {
+            compactLines.emplace_back(parser.parse(line, table));
+        }
+    }
+    addBest("SGREncoder::encode", bytes, [&] {
+        SGREncoder  encoder(defaultAttr, defaultAttr);
+        std::string out;
+        for (const auto& line : compactLines) {
+            encoder.encode(line, table, out);
+            out += '\n';
+        }
+        sink = out.size();
+    });
+
+    // quantize the runs of all parsed lines, the runs are copied first
+    std::vector<TextColorAttr> runs;
+    {
+        TextParser parser(defaultAttr, defaultAttr);
+        for (const auto& line : corpus.lines) {
+            auto text = parser.parse(line);
+            runs.insert(runs.end(), text.color.begin(), text.color.end());
+        }
+    }
+    for (auto palette : { ColorQuantizer::Palette::COLOR_256, ColorQuantizer::Palette::COLOR_16 }) {
+        bool is256 = palette == ColorQuantizer::Palette::COLOR_256;
+        addBest(is256 ? "ColorQuantizer::quantize(256)" : "ColorQuantizer::quantize(16)", bytes, [&] {
+            auto quantized = runs;
+            ColorQuantizer::quantize(quantized.data(), quantized.size(), palette);
+            sink = quantized.empty() ? 0 : quantized.back().color.front.r;
+        });
+    }
+
+    addBest("SGRPipeline::run", bytes, [&] {
+        SGRPipeline pipeline(defaultAttr, defaultAttr, {});
+        size_t      pos       = 0;
+        size_t      textBytes = 0;
+        auto        reader    = [&](char* buf, size_t size) {
+            size = std::min(size, corpus.joined.size() - pos);
+            std::memcpy(buf, corpus.joined.data() + pos, size);
+            pos += size;
+            return size;
+        };
+        pipeline.run(reader, [&textBytes](const SGRPipeline::RunBatch& batch) { textBytes += batch.text.size(); });
+        sink = textBytes;
+    });
+
+    addBest("IncrementalDocument::append", bytes, [&] {
+        constexpr size_t    chunkSize = 4096;
+        IncrementalDocument document(defaultAttr, defaultAttr);
+        size_t              changed = 0;
+        for (size_t pos = 0; pos < corpus.joined.size(); pos += chunkSize) {
+            changed += document.append(std::string_view(corpus.joined).substr(pos, chunkSize)).lineCnt;
+        }
+        sink = changed;
+    });
+
+    addBest("Scrollback::append", bytes, [&] {
+        Scrollback scrollback(defaultAttr, defaultAttr, 10000, 1 << 20);
+        for (const auto& line : corpus.lines) {
+            scrollback.append(line);
+        }
+        sink = scrollback.size();
+    });
+
+    addBest("CheckpointIndex::update", bytes, [&] {
+        CheckpointIndex index(defaultAttr, defaultAttr, 10000, 1 << 20);
+        index.update(corpus.joined);
+        sink = index.checkpoints().size();
+    });
+
+    addBest("HTMLRenderer::render", bytes, [&] {
+        constexpr size_t chunkSize = 4096;
+        HTMLRenderer     renderer(defaultAttr, defaultAttr);
+        std::string      html;
+        size_t           htmlBytes = 0;
+        for (size_t pos = 0; pos < corpus.joined.size(); pos += chunkSize) {
+            renderer.render(std::string_view(corpus.joined).substr(pos, chunkSize), html);
+            htmlBytes += html.size();
+            html.clear();
+        }
+        renderer.finish(html);
+        sink = htmlBytes + html.size();
+    });
+}
+
+static void printResults(const std::vector<Result>& results, const Options& options)
+{
+    bool json = options.format == "json";
+    if (json) {
+        std::printf("[\n");
+    }
+    else {
+        std::printf("corpus,bench,bytes,sequences,seconds,bytes_per_second,sequences_per_second\n");
+    }
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& result      = results[i];
+        double      bytesPerSec = result.seconds > 0 ? double(result.bytes) / result.seconds : 0;
+        double      seqsPerSec  = result.seconds > 0 ? double(result.sequences) / result.seconds : 0;
+        if (json) {
+            std::printf("  {\"corpus\": \"%s\", \"bench\": \"%s\", \"bytes\": %zu, \"sequences\": %zu, "
+                        "\"seconds\": %.6f, \"bytes_per_second\": %.0f, \"sequences_per_second\": %.0f}%s\n",
+                        result.corpus.c_str(), result.bench.c_str(), result.bytes, result.sequences, result.seconds,
+                        bytesPerSec, seqsPerSec, i + 1 < results.size() ? "," : "");
+        }
+        else {
+            std::printf("%s,%s,%zu,%zu,%.6f,%.0f,%.0f\n", result.corpus.c_str(), result.bench.c_str(), result.bytes,
+                        result.sequences, result.seconds, bytesPerSec, seqsPerSec);
+        }
+    }
+
+    if (json) {
+        std::printf("]\n");
+    }
+}
+
+static void usage(const char* name)
+{
+    std::fprintf(stderr,
+                 "usage: %s [--format csv|json] [--size MiB] [--iterations N]\n"
+                 "  --format      output format, default csv\n"
+                 "  --size        bytes of every generated corpus in MiB, default 8\n"
+                 "  --iterations  runs of every benchmark, the best one is reported, default 5\n",
+                 name);
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--format") == 0 && hasValue) {
+            options.format = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--size") == 0 && hasValue) {
+            options.corpusBytes = std::strtoull(argv[++i], nullptr, 10) << 20;
+        }
+        else if (std::strcmp(argv[i], "--iterations") == 0 && hasValue) {
+            options.iterations = std::atoi(argv[++i]);
+        }
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if ((options.format != "csv" && options.format != "json") || options.iterations <= 0
+        || options.corpusBytes == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    CorpusGenerator     generator(options.corpusBytes);
+    std::vector<Result> results;
+    runCorpus(generator.plain(), options, results);
+    runCorpus(generator.sparse4Bit(), options, results);
+    runCorpus(generator.dense(), options, results);
+    runCorpus(generator.diagnostics(), options, results);
+    runCorpus(generator.malformed(), options, results);
+    runCorpus(generator.unicode(), options, results);
+
+    printResults(results, options);
+    return 0;
+}
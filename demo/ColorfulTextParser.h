@@ -4,41 +4,37 @@
 
 #pragma once
 
+#include <string_view>
+#include <utility>
 #include <vector>
 
 #include <QString>
 
 #include "SGRParser.h"
+#include "TextParser.h"
 
-struct TextColorAttr {
-    ANSI::Color color;
-    size_t      start;
-    size_t      len;
-};
-
-struct ColorfulText {
-    std::string                text;
-    std::vector<TextColorAttr> color;
-};
+using TextColorAttr = ANSI::TextColorAttr;
+using ColorfulText  = ANSI::ColorfulText;
+using ColumnText    = ANSI::ColumnText;
 
 class CSIFilter {
 public:
     CSIFilter()  = default;
     ~CSIFilter() = default;
 
-    // ANSI: start, data
+    // ANSI: start, data. start is a UTF-8 byte offset for both QString and std::string
     using SGRSequence = std::pair<size_t, std::string>;
 
     static std::vector<SGRSequence> filter(QString& stdText);
     static std::vector<SGRSequence> filter(std::string& stdText);
+
+    // remove CSI and OSC sequences in place, nothing is recorded
+    static void strip(std::string& stdText);
 };
 
 class ColorfulTextParser {
 public:
-    enum class Mode {
-        MARKED_TEXT,
-        ALL_TEXT,
-    };
+    using Mode = ANSI::TextParser::Mode;
 
 public:
     explicit ColorfulTextParser(const ANSI::TextAttribute& defaultAttr, const ANSI::TextAttribute& currentAttr);
@@ -48,19 +44,21 @@ public:
 
     std::vector<ColorfulText> parse(const std::vector<QString>& strings, Mode mode = Mode::ALL_TEXT);
 
+    // with code points and terminal columns of the runs, see ANSI::TextParser::parseColumns
+    ColumnText parseColumns(const QString& string, Mode mode = Mode::ALL_TEXT);
+
     // std::string
     ColorfulText parse(std::string strings, Mode mode = Mode::ALL_TEXT);
 
     std::vector<ColorfulText> parse(const std::vector<std::string>& strings, Mode mode = Mode::ALL_TEXT);
 
-private:
-    // std::string
-    void markedStringToText(std::vector<ColorfulText>& textList, const std::vector<CSIFilter::SGRSequence>& sgrSeqs,
-                            std::string&& string);
-    void allStringToText(std::vector<ColorfulText>& textList, const std::vector<CSIFilter::SGRSequence>& sgrSeqs,
-                         std::string&& string);
+    // runs are passed to visitor instead of building ColorfulText, see ANSI::TextParser::visit
+    template <typename Visitor>
+    void visit(std::string_view string, Visitor&& visitor, Mode mode = Mode::ALL_TEXT)
+    {
+        textParser_.visit(string, std::forward<Visitor>(visitor), mode);
+    }
 
 private:
-    ANSI::TextAttribute currentTextAttr_;
-    ANSI::SGRParser     sgrParser_;
+    ANSI::TextParser textParser_;
 };
@@ -0,0 +1,190 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include "ColorfulTextWidget.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+#include <QEvent>
+#include <QFontMetrics>
+#include <QPaintEvent>
+#include <QPainter>
+#include <QScrollBar>
+#include <QVector>
+
+static constexpr int DEFAULT_LAYOUT_CACHE_LINES = 4096;
+
+static QColor colorOf(const ANSI::RGB& rgb)
+{
+    return { rgb.r, rgb.g, rgb.b };
+}
+
+ColorfulTextWidget::ColorfulTextWidget(const ANSI::TextAttribute& defaultAttr, QWidget* parent)
+    : QAbstractScrollArea(parent)
+    , defaultAttr_(defaultAttr)
+    , document_(defaultAttr, defaultAttr)
+    , layouts_(DEFAULT_LAYOUT_CACHE_LINES)
+    , lineHeight_(std::max(1, QFontMetrics(font()).lineSpacing()))
+    , maxLineWidth_(0)
+    , followTail_(true)
+{
+    // the whole viewport is painted, so Qt does not need to clear it first
+    viewport()->setAttribute(Qt::WA_OpaquePaintEvent);
+    updateScrollBars();
+}
+
+void ColorfulTextWidget::append(std::string_view data)
+{
+    auto* bar      = verticalScrollBar();
+    bool  atBottom = bar->value() == bar->maximum();
+    auto  change   = document_.append(data);
+    if (change.lineCnt == 0) {
+        return;
+    }
+
+    // only the last line before data can be cached and changed, the others are new
+    layouts_.remove(change.firstLine);
+    updateScrollBars();
+    if (followTail_ && atBottom) {
+        // scrollContentsBy() repaints the lines scrolled in
+        bar->setValue(bar->maximum());
+    }
+
+    qint64 top = qint64(change.firstLine) - bar->value();
+    if (top < pageLineCount() + 1) {
+        int y = int(std::max<qint64>(top, 0)) * lineHeight_;
+        viewport()->update(0, y, viewport()->width(), viewport()->height() - y);
+    }
+}
+
+void ColorfulTextWidget::clear()
+{
+    document_.clear();
+    layouts_.clear();
+    maxLineWidth_ = 0;
+    updateScrollBars();
+    viewport()->update();
+}
+
+void ColorfulTextWidget::setLayoutCacheSize(int lines)
+{
+    layouts_.setMaxCost(std::max(1, lines));
+}
+
+void ColorfulTextWidget::paintEvent(QPaintEvent* event)
+{
+    QPainter painter(viewport());
+    auto     rect = event->rect();
+    painter.fillRect(rect, colorOf(defaultAttr_.color.back));
+
+    // lines which intersect the exposed rectangle
+    size_t firstLine  = size_t(verticalScrollBar()->value());
+    size_t begin      = firstLine + size_t(rect.top() / lineHeight_);
+    size_t end        = std::min(document_.size(), firstLine + size_t(rect.bottom() / lineHeight_) + 1);
+    int    x          = -horizontalScrollBar()->value();
+    int    widthLimit = maxLineWidth_;
+    for (size_t line = begin; line < end; ++line) {
+        int y = int(line - firstLine) * lineHeight_;
+        layoutOf(line)->draw(&painter, QPointF(x, y), {}, rect);
+    }
+
+    if (maxLineWidth_ != widthLimit) {
+        updateScrollBars();
+    }
+}
+
+void ColorfulTextWidget::resizeEvent(QResizeEvent* event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+void ColorfulTextWidget::scrollContentsBy(int dx, int dy)
+{
+    // the vertical scroll bar counts lines, the horizontal one pixels
+    viewport()->scroll(dx, dy * lineHeight_);
+}
+
+void ColorfulTextWidget::changeEvent(QEvent* event)
+{
+    if (event->type() == QEvent::FontChange) {
+        lineHeight_   = std::max(1, QFontMetrics(font()).lineSpacing());
+        maxLineWidth_ = 0;
+        layouts_.clear();
+        updateScrollBars();
+        viewport()->update();
+    }
+    QAbstractScrollArea::changeEvent(event);
+}
+
+QTextLayout* ColorfulTextWidget::layoutOf(size_t line)
+{
+    if (auto* layout = layouts_.object(line)) {
+        return layout;
+    }
+
+    // runs are UTF-8 byte offsets, formats need UTF-16 offsets, so the text is converted run by run
+    auto                              view = document_[line];
+    QString                           text;
+    QVector<QTextLayout::FormatRange> formats;
+    formats.reserve(int(view.colorCnt));
+    size_t textPos = 0;
+    for (const auto& run : view) {
+        if (run.start > textPos) {
+            text += QString::fromUtf8(view.text.data() + textPos, int(run.start - textPos));
+        }
+
+        QTextLayout::FormatRange range;
+        range.start = text.size();
+        text += QString::fromUtf8(view.text.data() + run.start, int(run.len));
+        range.length = text.size() - range.start;
+        range.format.setForeground(colorOf(run.color.front));
+        range.format.setBackground(colorOf(run.color.back));
+        formats.push_back(range);
+        textPos = run.start + run.len;
+    }
+    if (textPos < view.text.size()) {
+        text += QString::fromUtf8(view.text.data() + textPos, int(view.text.size() - textPos));
+    }
+
+    // one line of all characters, it is never wrapped
+    auto* layout = new QTextLayout(text, font());
+    layout->setFormats(formats);
+    layout->setCacheEnabled(true);
+    layout->beginLayout();
+    auto textLine = layout->createLine();
+    if (textLine.isValid()) {
+        textLine.setNumColumns(text.size());
+        textLine.setPosition({ 0, 0 });
+        maxLineWidth_ = std::max(maxLineWidth_, int(std::ceil(textLine.naturalTextWidth())));
+    }
+    layout->endLayout();
+
+    // the cache owns the layout, it is valid until the next insert
+    layouts_.insert(line, layout);
+    return layout;
+}
+
+void ColorfulTextWidget::updateScrollBars()
+{
+    int pageLines = pageLineCount();
+    int lineCnt   = int(std::min<size_t>(document_.size(), INT_MAX));
+
+    auto* vertical = verticalScrollBar();
+    vertical->setSingleStep(1);
+    vertical->setPageStep(pageLines);
+    vertical->setRange(0, std::max(0, lineCnt - pageLines));
+
+    auto* horizontal = horizontalScrollBar();
+    horizontal->setSingleStep(QFontMetrics(font()).averageCharWidth());
+    horizontal->setPageStep(viewport()->width());
+    horizontal->setRange(0, std::max(0, maxLineWidth_ - viewport()->width()));
+}
+
+int ColorfulTextWidget::pageLineCount() const
+{
+    return std::max(1, viewport()->height() / lineHeight_);
+}
@@ -0,0 +1,67 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#pragma once
+
+#include <string_view>
+
+#include <QAbstractScrollArea>
+#include <QCache>
+#include <QTextLayout>
+
+#include "IncrementalDocument.h"
+
+/*
+ * Read only view of colorful text lines, example: a tailed log.
+ *
+ * Text is parsed once when it is appended. A line is laid out by QTextLayout with a FormatRange per run the first
+ * time it is painted and the layout is cached, so a repaint only draws shaped glyphs. Only the lines in the exposed
+ * rectangle are painted and the vertical scroll bar counts lines, so the view does not slow down with more lines.
+ */
+class ColorfulTextWidget : public QAbstractScrollArea {
+    Q_OBJECT
+
+public:
+    explicit ColorfulTextWidget(const ANSI::TextAttribute& defaultAttr, QWidget* parent = nullptr);
+    ~ColorfulTextWidget() override = default;
+
+    // bytes of the text, lines are separated by '\n', see ANSI::IncrementalDocument::append
+    void append(std::string_view data);
+
+    void clear();
+
+    inline size_t lineCount() const { return document_.size(); }
+
+    // scroll to the new lines when text is appended while the last line is visible, enabled by default
+    inline void setFollowTail(bool follow) { followTail_ = follow; }
+
+    // most lines whose layout is cached, 4096 by default
+    void setLayoutCacheSize(int lines);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+
+    void resizeEvent(QResizeEvent* event) override;
+
+    void scrollContentsBy(int dx, int dy) override;
+
+    void changeEvent(QEvent* event) override;
+
+private:
+    // cached layout of line, laid out if it is not cached
+    QTextLayout* layoutOf(size_t line);
+
+    void updateScrollBars();
+
+    // lines which fit in the viewport, at least 1
+    int pageLineCount() const;
+
+private:
+    ANSI::TextAttribute          defaultAttr_;
+    ANSI::IncrementalDocument    document_;
+    QCache<quint64, QTextLayout> layouts_;
+    int                          lineHeight_;
+    int                          maxLineWidth_; // widest line laid out so far
+    bool                         followTail_;
+};
@@ -1,15 +1,10 @@
 #include <QApplication>
-#include <QDebug>
 #include <QMainWindow>
-#include <QPaintEvent>
-#include <QPainter>
-#include <QRect>
-#include <qlogging.h>
 
-#include <cinttypes>
+#include <string>
+#include <vector>
 
-#include "ColorfulTextParser.h"
-#include "SGRParser.h"
+#include "ColorfulTextWidget.h"
 
 using namespace ANSI;
 
@@ -35,99 +30,37 @@ std::vector<std::string> vec {
     "\033[1;38;2;95;135;175;48;2;215;0;0mhello\033[m",
 };
 
-QDebug& operator<<(QDebug& o, const ANSI::RGB& rgb)
-{
-    // color value len*3 + ,*2 + () + \0
-    constexpr auto len = 3 * 3 + 2 + 2 + 2;
-    char           rgbString[len] {};
-    snprintf(rgbString, len - 1, "(%" PRIu8 ",%" PRIu8 ",%" PRIu8 ")", rgb.r, rgb.g, rgb.b);
-    o << rgbString;
-    return o;
-}
+// lines appended after the test sequences to show virtual scrolling
+static constexpr size_t GENERATED_LINE_CNT = 1000000;
 
 class MyWindow : public QMainWindow {
 private:
-    Color defaultColor_;
+    ColorfulTextWidget* textWidget_;
 
 public:
     MyWindow()
         : QMainWindow(nullptr)
-        , defaultColor_ {
-            { 0, 0, 0 },
-            { 255, 255, 255 },
-        }
-    {
-    }
-
-    void paintEvent(QPaintEvent* event) override
+        , textWidget_(new ColorfulTextWidget({ TextAttribute::State::DEFAULT, { { 0, 0, 0 }, { 255, 255, 255 } } },
+                                             this))
     {
-        // set font and init painter
-        auto font = this->font();
+        auto font = textWidget_->font();
         font.setPixelSize(50);
-        this->setFont(font);
-
-        QPainter painter(this);
-
-        // set initial start point
-        constexpr int initX = 50;
-        constexpr int initY = 50;
-
-        constexpr int margin       = 3;
-        int           maxTextWidth = 0;
-        int           fontHeight   = painter.fontMetrics().height();
-
-        // Text: description string and the color range
-        // parse ansi color from string, then storage to Text
-        ColorfulTextParser parser({ TextAttribute::State::DEFAULT, defaultColor_ },
-                                  { TextAttribute::State::DEFAULT, defaultColor_ });
-        //        std::vector<ColorfulText> textList;
-        //        for (auto& str : vec) {
-        //            auto ret = parser.parse({ str.c_str(), str.size() }, ColorfulTextParser::Mode::MARKED_TEXT);
-        //            textList.emplace_back(ret);
-        //        }
+        textWidget_->setFont(font);
 
-        std::vector<ColorfulText> textList = parser.parse(vec);
-
-        int y = initY;
-        for (auto& text : textList) {
-            auto& string = text.text;
-            int   x      = initX;
-
-            int testWidth = painter.fontMetrics().horizontalAdvance(QString(string.c_str()));
-            maxTextWidth  = testWidth > maxTextWidth ? testWidth : maxTextWidth;
-            for (auto& textColor : text.color) {
-                auto substr = string.substr(textColor.start, textColor.len);
-
-                // record max string width
-
-                auto& front = textColor.color.front;
-                auto& back  = textColor.color.back;
-                qDebug() << "front:" << front;
-                qDebug() << "back:" << back;
-
-                int width = painter.fontMetrics().horizontalAdvance(QString(substr.c_str()));
-
-                // draw background
-                auto backColor = QColor(back.r, back.g, back.b);
-                painter.fillRect(x, y, width, fontHeight + margin, backColor);
-
-                // draw text
-                auto frontColor = QColor(front.r, front.g, front.b);
-                painter.setPen(frontColor);
-                painter.drawText(x, y + fontHeight, substr.c_str());
-
-                // move to next position
-                x += width;
-            }
-            // move to next line
-            y += (fontHeight + margin);
+        // text is parsed once here, paintEvent only draws the cached layouts of the exposed lines
+        std::string text;
+        for (const auto& line : vec) {
+            text += line;
+            text += '\n';
+        }
+        for (size_t i = 0; i < GENERATED_LINE_CNT; ++i) {
+            text += "\033[38;5;" + std::to_string(i % 256) + "mline " + std::to_string(i) + "\033[m\n";
         }
+        textWidget_->setFollowTail(false);
+        textWidget_->append(text);
 
-        // set window height and width
-        auto windowHeight = fontHeight * (int)vec.size() + 2 * initY;
-        this->setFixedHeight(windowHeight);
-        auto windowWidth = maxTextWidth + initY * 2;
-        this->setFixedWidth(windowWidth);
+        setCentralWidget(textWidget_);
+        resize(800, 600);
     }
 };
 
@@ -0,0 +1,560 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "CSIScanner.h"
+#include "HTMLRenderer.h"
+#include "TextParser.h"
+
+using namespace ANSI;
+
+static const TextAttribute defaultAttr { TextAttribute::State::DEFAULT, { { 0, 0, 0 }, { 255, 255, 255 } } };
+
+static constexpr std::string_view SPAN_END = "</span>";
+
+enum class Format {
+    TEXT, // text without control sequences
+    HTML, // HTMLRenderer output in <pre>
+    RUNS, // one line per run: start len state front back, start is the offset in the text output
+};
+
+struct Options {
+    Format                   format     = Format::TEXT;
+    size_t                   threadCnt  = 0;
+    size_t                   chunkBytes = 4 << 20;
+    bool                     stats      = false;
+    std::string              output;
+    std::vector<std::string> inputs;
+};
+
+// input file, a regular file is mapped, other inputs are read in windows
+class InputFile {
+public:
+    InputFile() = default;
+    ~InputFile()
+    {
+        if (addr_ != nullptr) {
+            munmap(addr_, size_);
+        }
+        if (fd_ > STDIN_FILENO) {
+            ::close(fd_);
+        }
+    }
+
+    InputFile(const InputFile&)            = delete;
+    InputFile(InputFile&&)                 = delete;
+    InputFile& operator=(const InputFile&) = delete;
+    InputFile& operator=(InputFile&&)      = delete;
+
+    // "-" is stdin
+    bool open(const std::string& path)
+    {
+        fd_ = path == "-" ? STDIN_FILENO : ::open(path.c_str(), O_RDONLY);
+        if (fd_ < 0) {
+            return false;
+        }
+        struct stat st {};
+        if (fstat(fd_, &st) != 0) {
+            return false;
+        }
+        if (S_ISREG(st.st_mode) && st.st_size > 0) {
+            void* addr = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd_, 0);
+            // a file which can not be mapped is read like a pipe
+            if (addr != MAP_FAILED) {
+                addr_ = addr;
+                size_ = size_t(st.st_size);
+                madvise(addr_, size_, MADV_SEQUENTIAL);
+            }
+        }
+        return true;
+    }
+
+    inline bool mapped() const { return addr_ != nullptr; }
+
+    // bytes of a mapped file
+    inline std::string_view data() const { return { static_cast<const char*>(addr_), size_ }; }
+
+    /*
+     * Append bytes of an input which is not mapped, stop at capacity or when no more bytes are ready,
+     * so a slow stream like tail -f is converted as soon as a line comes.
+     *
+     * @param window    bytes read, not converted yet
+     * @param capacity  most bytes of window
+     * @return          false on a read error
+     */
+    bool read(std::string& window, size_t capacity)
+    {
+        size_t size = window.size();
+        window.resize(std::max(capacity, size + 1));
+        bool ok = true;
+        while (size < window.size()) {
+            auto len = ::read(fd_, &window[size], window.size() - size);
+            if (len < 0 && errno == EINTR) {
+                continue;
+            }
+            if (len <= 0) {
+                ok   = len == 0;
+                eof_ = true;
+                break;
+            }
+            size += size_t(len);
+
+            pollfd ready { fd_, POLLIN, 0 };
+            if (poll(&ready, 1, 0) <= 0) {
+                break;
+            }
+        }
+        window.resize(size);
+        return ok;
+    }
+
+    inline bool eof() const { return eof_; }
+
+private:
+    int    fd_   = -1;
+    void*  addr_ = nullptr;
+    size_t size_ = 0;
+    bool   eof_  = false;
+};
+
+/*
+ * Bytes of a window which can be converted now, the rest is kept until more bytes come.
+ *
+ * A sequence can not contain a line feed, so the window is cut after its last one. A window without one
+ * is only cut when it is full, before the sequence which can still be completed at its end.
+ */
+static size_t completeBytes(std::string_view window, size_t capacity, bool eof)
+{
+    if (eof) {
+        return window.size();
+    }
+    auto lineEnd = window.rfind('\n');
+    if (lineEnd != std::string_view::npos) {
+        return lineEnd + 1;
+    }
+    if (window.size() < capacity) {
+        return 0;
+    }
+    auto incomplete = CSIScanner::incompleteLen(window);
+    return incomplete == window.size() ? window.size() : window.size() - incomplete;
+}
+
+/*
+ * Convert the input in windows of threadCnt line aligned chunks, so memory does not depend on the input size.
+ *
+ * The attribute at the start of a chunk is found by composing the TextAttributeTransform of the chunks before it,
+ * a sequence can not contain a line feed, so no sequence is split by a chunk border. Every format finds CSI
+ * sequences and OSC with CSIScanner::visit, so they remove the same bytes.
+ */
+class Converter {
+public:
+    Converter(const Options& options, FILE* out)
+        : options_(options)
+        , out_(out)
+        , currentAttr_(defaultAttr)
+        , textOffset_(0)
+        , pending_ { 0, 0, defaultAttr }
+        , hasPending_(false)
+        , spanOpen_(false)
+        , spanAttr_(defaultAttr)
+        , inBytes_(0)
+        , outBytes_(0)
+    {
+        if (options_.format == Format::HTML) {
+            write("<pre>\n");
+        }
+    }
+
+    void convert(std::string_view data)
+    {
+        inBytes_ += data.size();
+        while (!data.empty()) {
+            split(data);
+            data.remove_prefix(chunks_.back().source.data() + chunks_.back().source.size() - data.data());
+
+            // RUNS and HTML need the start attribute of every chunk
+            if (options_.format != Format::TEXT) {
+                forEachChunk([](Chunk& chunk) {
+                    TextParser parser(defaultAttr, defaultAttr);
+                    parser.sgrParser().enableCache(true);
+                    chunk.transform = parser.transform(chunk.source);
+                });
+                for (auto& chunk : chunks_) {
+                    chunk.startAttr = currentAttr_;
+                    currentAttr_    = chunk.transform.apply(currentAttr_);
+                }
+            }
+
+            forEachChunk([this](Chunk& chunk) { render(chunk); });
+            for (const auto& chunk : chunks_) {
+                writeChunk(chunk);
+            }
+        }
+    }
+
+    void finish()
+    {
+        writePending();
+        if (options_.format == Format::HTML) {
+            if (spanOpen_) {
+                write(SPAN_END);
+            }
+            write("</pre>\n");
+        }
+        std::fflush(out_);
+    }
+
+    inline size_t inBytes() const { return inBytes_; }
+
+    inline size_t outBytes() const { return outBytes_; }
+
+    inline size_t threadCnt() const { return options_.threadCnt; }
+
+private:
+    struct Run {
+        size_t        start; // relative to the text of the chunk
+        size_t        len;
+        TextAttribute attr;
+    };
+
+    // HTML of a chunk starts without an open span, spans are joined across chunk borders when it is written
+    struct HTMLEdges {
+        bool          hasText   = false;
+        TextAttribute firstAttr = defaultAttr; // attribute of the first text
+        size_t        textStart = 0;           // HTML after the span tag of the first text
+        bool          spanOpen  = false;       // span at the end, not closed yet
+        TextAttribute spanAttr  = defaultAttr;
+    };
+
+    struct Chunk {
+        std::string_view       source;
+        TextAttributeTransform transform { 0, defaultAttr };
+        TextAttribute          startAttr = defaultAttr;
+        std::string            out;
+        std::vector<Run>       runs;
+        size_t                 textSize = 0;
+        HTMLEdges              html;
+    };
+
+    // split the next window of data into line aligned chunks
+    void split(std::string_view data)
+    {
+        chunks_.resize(options_.threadCnt);
+        size_t cnt = 0;
+        size_t pos = 0;
+        while (cnt < options_.threadCnt && pos < data.size()) {
+            size_t end = std::min(pos + options_.chunkBytes, data.size());
+            if (end < data.size()) {
+                auto lineEnd = static_cast<const char*>(std::memchr(data.data() + end, '\n', data.size() - end));
+                end          = lineEnd == nullptr ? data.size() : size_t(lineEnd - data.data()) + 1;
+            }
+
+            auto& chunk  = chunks_[cnt++];
+            chunk.source = data.substr(pos, end - pos);
+            chunk.out.clear();
+            chunk.runs.clear();
+            chunk.textSize = 0;
+            chunk.html     = {};
+            pos            = end;
+        }
+        chunks_.resize(cnt);
+    }
+
+    template <typename Func>
+    void forEachChunk(Func&& func)
+    {
+        std::vector<std::thread> threads;
+        threads.reserve(chunks_.size());
+        for (size_t i = 1; i < chunks_.size(); ++i) {
+            threads.emplace_back([&func, this, i] { func(chunks_[i]); });
+        }
+        func(chunks_[0]);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    void render(Chunk& chunk)
+    {
+        switch (options_.format) {
+        case Format::TEXT: {
+            CSIScanner::strip(chunk.source, chunk.out);
+        } break;
+        case Format::HTML: {
+            struct Visitor {
+                HTMLRenderer& renderer;
+                Chunk&        chunk;
+
+                void onText(std::string_view text, const TextAttribute& attr)
+                {
+                    renderer.renderText(text, attr, chunk.out);
+                    auto& edges = chunk.html;
+                    if (!edges.hasText) {
+                        edges.hasText   = true;
+                        edges.firstAttr = attr;
+                        edges.textStart = renderer.spanOpen() ? chunk.out.find('>') + 1 : 0;
+                    }
+                }
+
+                void onAttrChange(const TextAttribute&, const TextAttribute&) {}
+            };
+
+            // the parser of the other formats, the renderer only escapes and writes spans
+            HTMLRenderer renderer(defaultAttr, chunk.startAttr);
+            TextParser   parser(defaultAttr, chunk.startAttr);
+            parser.sgrParser().enableCache(true);
+            parser.visit(chunk.source, Visitor { renderer, chunk });
+            chunk.html.spanOpen = renderer.spanOpen();
+            chunk.html.spanAttr = renderer.spanAttr();
+        } break;
+        case Format::RUNS: {
+            struct Visitor {
+                Chunk& chunk;
+
+                void onText(std::string_view text, const TextAttribute& attr)
+                {
+                    auto& runs = chunk.runs;
+                    // text between two sequences which do not change the attribute is one run
+                    if (!runs.empty() && runs.back().attr == attr) {
+                        runs.back().len += text.size();
+                    }
+                    else {
+                        runs.push_back({ chunk.textSize, text.size(), attr });
+                    }
+                    chunk.textSize += text.size();
+                }
+
+                void onAttrChange(const TextAttribute&, const TextAttribute&) {}
+            } visitor { chunk };
+
+            TextParser parser(defaultAttr, chunk.startAttr);
+            parser.sgrParser().enableCache(true);
+            parser.visit(chunk.source, visitor);
+        } break;
+        }
+    }
+
+    void writeChunk(const Chunk& chunk)
+    {
+        if (options_.format == Format::HTML) {
+            writeHTML(chunk);
+            return;
+        }
+        if (options_.format != Format::RUNS) {
+            write(chunk.out);
+            return;
+        }
+
+        // a run is written when the next one is known, so runs are joined across chunk borders too
+        for (const auto& run : chunk.runs) {
+            if (hasPending_ && pending_.attr == run.attr) {
+                pending_.len += run.len;
+                continue;
+            }
+            writePending();
+            pending_    = { textOffset_ + run.start, run.len, run.attr };
+            hasPending_ = true;
+        }
+        textOffset_ += chunk.textSize;
+    }
+
+    // the HTML of one renderer for the whole input
+    void writeHTML(const Chunk& chunk)
+    {
+        const auto&      edges = chunk.html;
+        std::string_view html  = chunk.out;
+        if (edges.hasText) {
+            // the first text of the chunk continues the open span or closes it
+            if (spanOpen_ && edges.firstAttr == spanAttr_) {
+                html.remove_prefix(edges.textStart);
+            }
+            else if (spanOpen_) {
+                write(SPAN_END);
+            }
+            spanOpen_ = edges.spanOpen;
+            spanAttr_ = edges.spanAttr;
+        }
+        write(html);
+    }
+
+    void writePending()
+    {
+        if (!hasPending_) {
+            return;
+        }
+
+        char        line[96];
+        const auto& front = pending_.attr.color.front;
+        const auto& back  = pending_.attr.color.back;
+        auto        len   = std::snprintf(line, sizeof(line), "%zu %zu %s %02x%02x%02x %02x%02x%02x\n", pending_.start,
+                                          pending_.len,
+                                          pending_.attr.state == TextAttribute::State::CUSTOM ? "custom" : "default",
+                                          front.r, front.g, front.b, back.r, back.g, back.b);
+        write({ line, size_t(len) });
+        hasPending_ = false;
+    }
+
+    void write(std::string_view data)
+    {
+        std::fwrite(data.data(), 1, data.size(), out_);
+        outBytes_ += data.size();
+    }
+
+private:
+    const Options&     options_;
+    FILE*              out_;
+    std::vector<Chunk> chunks_;
+    TextAttribute      currentAttr_; // attribute after the converted data
+    size_t             textOffset_;  // text size of the converted data, used by RUNS
+    Run                pending_;     // last run of RUNS, not written yet
+    bool               hasPending_;
+    bool               spanOpen_; // HTML span of the written chunks, not closed yet
+    TextAttribute      spanAttr_;
+    size_t             inBytes_;
+    size_t             outBytes_;
+};
+
+static void usage(const char* name)
+{
+    std::fprintf(stderr,
+                 "usage: %s [--format text|html|runs] [--threads N] [--chunk MiB] [--stats] [-o file] [file...]\n"
+                 "  --format      text: remove control sequences, default\n"
+                 "                html: escaped text with colored spans in <pre>\n"
+                 "                runs: one line per run, \"start len state front back\"\n"
+                 "  --threads     worker threads, default hardware concurrency\n"
+                 "  --chunk       bytes of every chunk in MiB, default 4\n"
+                 "  --stats       print throughput to stderr\n"
+                 "  -o            output file, default stdout\n"
+                 "  file          input files, converted as one stream, default or \"-\" is stdin\n",
+                 name);
+}
+
+static bool parseOptions(int argc, char* argv[], Options& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--format") == 0 && hasValue) {
+            std::string_view format = argv[++i];
+            if (format == "text") {
+                options.format = Format::TEXT;
+            }
+            else if (format == "html") {
+                options.format = Format::HTML;
+            }
+            else if (format == "runs") {
+                options.format = Format::RUNS;
+            }
+            else {
+                return false;
+            }
+        }
+        else if (std::strcmp(argv[i], "--threads") == 0 && hasValue) {
+            options.threadCnt = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--chunk") == 0 && hasValue) {
+            options.chunkBytes = std::strtoull(argv[++i], nullptr, 10) << 20;
+        }
+        else if (std::strcmp(argv[i], "--stats") == 0) {
+            options.stats = true;
+        }
+        else if (std::strcmp(argv[i], "-o") == 0 && hasValue) {
+            options.output = argv[++i];
+        }
+        else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            return false;
+        }
+        else {
+            options.inputs.emplace_back(argv[i]);
+        }
+    }
+
+    if (options.threadCnt == 0) {
+        options.threadCnt = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (options.inputs.empty()) {
+        options.inputs.emplace_back("-");
+    }
+    return options.chunkBytes > 0;
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    FILE* out = stdout;
+    if (!options.output.empty()) {
+        out = std::fopen(options.output.c_str(), "wb");
+        if (out == nullptr) {
+            std::fprintf(stderr, "%s: can not open %s\n", argv[0], options.output.c_str());
+            return 1;
+        }
+    }
+
+    auto      begin = std::chrono::steady_clock::now();
+    Converter converter(options, out);
+    for (const auto& path : options.inputs) {
+        InputFile input;
+        if (!input.open(path)) {
+            std::fprintf(stderr, "%s: can not read %s\n", argv[0], path.c_str());
+            return 1;
+        }
+        if (input.mapped()) {
+            converter.convert(input.data());
+            continue;
+        }
+
+        // pipes are converted in windows of one chunk per thread, memory does not depend on the input size
+        const size_t capacity = options.threadCnt * options.chunkBytes;
+        std::string  window;
+        while (!input.eof()) {
+            if (!input.read(window, capacity)) {
+                std::fprintf(stderr, "%s: can not read %s\n", argv[0], path.c_str());
+                return 1;
+            }
+            size_t complete = completeBytes(window, capacity, input.eof());
+            converter.convert({ window.data(), complete });
+            window.erase(0, complete);
+            std::fflush(out);
+        }
+    }
+    converter.finish();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+
+    bool ok = std::ferror(out) == 0;
+    if (out != stdout) {
+        ok = std::fclose(out) == 0 && ok;
+    }
+    if (!ok) {
+        std::fprintf(stderr, "%s: write error\n", argv[0]);
+        return 1;
+    }
+
+    if (options.stats) {
+        double seconds = elapsed.count();
+        std::fprintf(stderr, "input %zu bytes, output %zu bytes, %zu threads, %.3f s, %.1f MiB/s\n",
+                     converter.inBytes(), converter.outBytes(), converter.threadCnt(), seconds,
+                     seconds > 0 ? double(converter.inBytes()) / seconds / (1 << 20) : 0.0);
+    }
+    return 0;
+}
@@ -55,6 +55,11 @@ enum SequenceSecond {
     SECOND_BYTE_END   = APC,
 };
 
+// terminator of OSC, besides ESC ST
+enum OSCTerminator {
+    BEL = 0x07, // Bell, used by xterm
+};
+
 // reference: https://www.ecma-international.org/publications-and-standards/standards/ecma-48/
 enum CSIParameterBytes {
     // ASCII: 0–9:;<=>?
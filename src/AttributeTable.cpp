@@ -0,0 +1,37 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include "AttributeTable.h"
+
+namespace ANSI {
+
+uint64_t AttributeTable::keyOf(const TextAttribute& attr)
+{
+    const auto& front = attr.color.front;
+    const auto& back  = attr.color.back;
+    return uint64_t(attr.state) << 48 | uint64_t(front.r) << 40 | uint64_t(front.g) << 32 | uint64_t(front.b) << 24
+        | uint64_t(back.r) << 16 | uint64_t(back.g) << 8 | uint64_t(back.b);
+}
+
+AttributeId AttributeTable::intern(const TextAttribute& attr)
+{
+    // runs next to each other often share the attribute
+    if (!attrs_.empty() && attrs_.back() == attr) {
+        return AttributeId(attrs_.size() - 1);
+    }
+
+    auto [it, inserted] = ids_.try_emplace(keyOf(attr), AttributeId(attrs_.size()));
+    if (inserted) {
+        attrs_.push_back(attr);
+    }
+    return it->second;
+}
+
+void AttributeTable::clear()
+{
+    attrs_.clear();
+    ids_.clear();
+}
+
+} // namespace ANSI
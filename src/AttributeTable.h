@@ -0,0 +1,51 @@
+//
+// Created by marvin on 26-10-17.
+//
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "SGRParser.h"
+
+namespace ANSI {
+
+using AttributeId = uint32_t;
+
+// a run of text with an interned attribute, 12 bytes instead of 24 for TextColorAttr
+struct CompactRun {
+    uint32_t    start;
+    uint32_t    len;
+    AttributeId attrId;
+};
+
+/*
+ * Maps every distinct TextAttribute to a small id, so runs store an id instead of the attribute.
+ *
+ * Ids start from 0 in interning order and stay valid until clear().
+ */
+class AttributeTable {
+public:
+    AttributeTable()  = default;
+    ~AttributeTable() = default;
+
+    AttributeId intern(const TextAttribute& attr);
+
+    // id must be returned by intern()
+    inline const TextAttribute& resolve(AttributeId id) const { return attrs_[id]; }
+
+    inline size_t size() const { return attrs_.size(); }
+
+    void clear();
+
+private:
+    // state and both colors packed in 49 bits
+    static uint64_t keyOf(const TextAttribute& attr);
+
+private:
+    std::vector<TextAttribute>                attrs_;
+    std::unordered_map<uint64_t, AttributeId> ids_;
+};
+
+} // namespace ANSI
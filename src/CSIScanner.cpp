@@ -0,0 +1,178 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include "CSIScanner.h"
+
+#include <cstring>
+
+namespace ANSI {
+
+// bytes at the end of text which can become an OSC when more bytes come, 0 if none
+static size_t incompleteOSCLen(std::string_view text)
+{
+    // an ESC which does not start ST cancels an OSC, so only the last "\033]" can start it
+    constexpr char oscHead[] { SequenceFirst::EXC, SequenceSecond::OSC, '\0' };
+    auto           pos = text.rfind(oscHead);
+    if (pos == std::string_view::npos) {
+        return 0;
+    }
+
+    // the command string can end with the ESC of ST, a line feed cancels it
+    constexpr char terminators[] { OSCTerminator::BEL, SequenceFirst::EXC, '\n', '\0' };
+    auto           end = text.back() == SequenceFirst::EXC ? text.size() - 1 : text.size();
+    if (text.substr(pos + HEAD_CNT, end - pos - HEAD_CNT).find_first_of(terminators) != std::string_view::npos
+        || text.size() - pos >= CSIScanner::MAX_OSC_LEN) {
+        return 0;
+    }
+    return text.size() - pos;
+}
+
+size_t CSIScanner::match(std::string_view text)
+{
+    if (text.size() < HEAD_CNT + 1 || text[0] != SequenceFirst::EXC || text[1] != SequenceSecond::CSI) {
+        return 0;
+    }
+    // bytes after the limit can not be part of a sequence
+    text = text.substr(0, MAX_SEQUENCE_LEN);
+
+    size_t pos = HEAD_CNT;
+    // parameter bytes
+    while (pos < text.size()) {
+        auto ch = static_cast<uint8_t>(text[pos]);
+        if (ch < CSIParameterBytes::CSI_PARAMETER_BEGIN || ch > CSIParameterBytes::CSI_PARAMETER_END) {
+            break;
+        }
+        ++pos;
+    }
+    // intermediate bytes
+    while (pos < text.size()) {
+        auto ch = static_cast<uint8_t>(text[pos]);
+        if (ch < CSIIntermediateBytes::CSIIntermediateBegin || ch > CSIIntermediateBytes::CSIIntermediateEnd) {
+            break;
+        }
+        ++pos;
+    }
+    // final byte
+    if (pos < text.size()) {
+        auto ch = static_cast<uint8_t>(text[pos]);
+        if (ch >= CSIFinalBytes::CSIFinalBegin && ch <= CSIFinalBytes::CSIFinalEnd) {
+            return pos + 1;
+        }
+    }
+    // incomplete sequence or invalid byte
+    return 0;
+}
+
+std::vector<CSISequence> CSIScanner::scan(std::string_view source, std::string& text)
+{
+    std::vector<CSISequence> seqs;
+    scan(source, text, seqs);
+    return seqs;
+}
+
+void CSIScanner::scan(std::string_view source, std::string& text, std::vector<CSISequence>& seqs)
+{
+    const auto textBegin = text.size();
+    text.reserve(textBegin + source.size());
+
+    visit(
+        source, [&text](std::string_view block) { text.append(block); },
+        [&](std::string_view sequence) { seqs.push_back({ text.size() - textBegin, sequence }); });
+}
+
+size_t CSIScanner::matchOSC(std::string_view text)
+{
+    if (text.size() < HEAD_CNT || text[0] != SequenceFirst::EXC || text[1] != SequenceSecond::OSC) {
+        return 0;
+    }
+    text = text.substr(0, MAX_OSC_LEN);
+
+    // a line feed cancels the command, so no sequence spans lines
+    constexpr char terminators[] { OSCTerminator::BEL, SequenceFirst::EXC, '\n', '\0' };
+    auto           pos = text.find_first_of(terminators, HEAD_CNT);
+    if (pos == std::string_view::npos || text[pos] == '\n') {
+        return 0;
+    }
+    if (text[pos] == OSCTerminator::BEL) {
+        return pos + 1;
+    }
+    // ESC must start ST, otherwise the command is cancelled and kept as text
+    if (pos + 1 < text.size() && text[pos + 1] == SequenceSecond::ST) {
+        return pos + 2;
+    }
+    return 0;
+}
+
+size_t CSIScanner::matchControl(std::string_view text)
+{
+    if (text.size() > 1 && text[1] == SequenceSecond::OSC) {
+        return matchOSC(text);
+    }
+    return match(text);
+}
+
+size_t CSIScanner::incompleteLen(std::string_view text)
+{
+    if (auto len = incompleteOSCLen(text); len != 0) {
+        return len;
+    }
+
+    // a CSI sequence can not contain ESC, so only the last one can start it
+    auto pos = text.rfind(char(SequenceFirst::EXC));
+    if (pos == std::string_view::npos) {
+        return 0;
+    }
+    if (pos + 1 == text.size()) {
+        return 1;
+    }
+    if (text[pos + 1] != SequenceSecond::CSI) {
+        return 0;
+    }
+
+    // parameter bytes, then intermediate bytes, the final byte is not there yet
+    auto i = pos + HEAD_CNT;
+    while (i < text.size() && static_cast<uint8_t>(text[i]) >= CSIParameterBytes::CSI_PARAMETER_BEGIN
+           && static_cast<uint8_t>(text[i]) <= CSIParameterBytes::CSI_PARAMETER_END) {
+        ++i;
+    }
+    while (i < text.size() && static_cast<uint8_t>(text[i]) >= CSIIntermediateBytes::CSIIntermediateBegin
+           && static_cast<uint8_t>(text[i]) <= CSIIntermediateBytes::CSIIntermediateEnd) {
+        ++i;
+    }
+    // the final byte would make it longer than a sequence can be
+    if (i != text.size() || text.size() - pos >= MAX_SEQUENCE_LEN) {
+        return 0;
+    }
+    return text.size() - pos;
+}
+
+void CSIScanner::strip(std::string_view source, std::string& text)
+{
+    text.reserve(text.size() + source.size());
+
+    visit(source, [&text](std::string_view block) { text.append(block); }, [](std::string_view) {});
+}
+
+size_t CSIScanner::strip(char* text, size_t len)
+{
+    // text only moves forward, so out never passes the bytes which are not scanned yet
+    char* out = text;
+    visit(
+        { text, len },
+        [&out](std::string_view block) {
+            if (out != block.data()) {
+                std::memmove(out, block.data(), block.size());
+            }
+            out += block.size();
+        },
+        [](std::string_view) {});
+    return out - text;
+}
+
+void CSIScanner::strip(std::string& text)
+{
+    text.resize(strip(text.data(), text.size()));
+}
+
+} // namespace ANSI
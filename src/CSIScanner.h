@@ -0,0 +1,133 @@
+//
+// Created by marvin on 26-10-17.
+//
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ANSI.h"
+#include "SIMD.h"
+
+namespace ANSI {
+
+struct CSISequence {
+    size_t           pos;      // start position in the filtered text
+    std::string_view sequence; // whole sequence in the source text, example: "\033[31m", or an OSC
+
+    // parameter and intermediate bytes, without "\033[" and final byte, example: "31"
+    inline std::string_view parameters() const
+    {
+        return sequence.substr(HEAD_CNT, sequence.size() - HEAD_CNT - 1);
+    }
+
+    inline uint8_t finalByte() const { return static_cast<uint8_t>(sequence.back()); }
+};
+
+class CSIScanner {
+public:
+    // a longer sequence is not a control sequence, its bytes are text, SGRStreamParser uses the same limit
+    static constexpr size_t MAX_SEQUENCE_LEN = 128;
+    // same for OSC, which carries titles and hyperlinks
+    static constexpr size_t MAX_OSC_LEN = 4096;
+
+public:
+    CSIScanner()  = delete;
+    ~CSIScanner() = delete;
+
+    /*
+     * @param text      text start with "\033["
+     * @return          length of the control sequence at the start of text, 0 if it is not a complete sequence
+     *                  of at most MAX_SEQUENCE_LEN bytes
+     *
+     * format: ESC [ parameter bytes(0x30–0x3F)* intermediate bytes(0x20–0x2F)* final byte(0x40–0x7E)
+     */
+    static size_t match(std::string_view text);
+
+    /*
+     * @param text      text start with "\033]"
+     * @return          length of the operating system command at the start of text, 0 if it is not a complete
+     *                  command of at most MAX_OSC_LEN bytes
+     *
+     * format: ESC ] command string, terminated by BEL or ESC \
+     * Another ESC or a line feed cancels the command, its bytes are text then.
+     */
+    static size_t matchOSC(std::string_view text);
+
+    /*
+     * @param text      text start with ESC
+     * @return          length of the CSI sequence or OSC at the start of text, 0 if there is none
+     */
+    static size_t matchControl(std::string_view text);
+
+    /*
+     * @param text      text which can end with a part of a sequence, example: the last line of a growing log
+     * @return          length of the bytes at the end of text which can still become a CSI sequence or OSC when
+     *                  more bytes come, 0 if there are none
+     */
+    static size_t incompleteLen(std::string_view text);
+
+    /*
+     * Scanner core of scan, strip and the parsers, nothing is allocated.
+     *
+     * @param source        source text, the views point into it
+     * @param onText        onText(std::string_view text) is called for the text between sequences, which may be empty
+     * @param onSequence    onSequence(std::string_view sequence) is called for every CSI sequence and OSC
+     *
+     * Invalid or incomplete sequences are text.
+     */
+    template <typename OnText, typename OnSequence>
+    static void visit(std::string_view source, OnText&& onText, OnSequence&& onSequence)
+    {
+        const char* end  = source.data() + source.size();
+        const char* text = source.data();
+        const char* cur  = text;
+        // jump from ESC to ESC, text before a sequence is reported in one block
+        while ((cur = SIMD::findEscape(cur, end)) != end) {
+            auto len = matchControl(std::string_view { cur, size_t(end - cur) });
+            if (len == 0) {
+                ++cur;
+                continue;
+            }
+
+            onText(std::string_view { text, size_t(cur - text) });
+            onSequence(std::string_view { cur, len });
+            cur += len;
+            text = cur;
+        }
+        onText(std::string_view { text, size_t(end - text) });
+    }
+
+    /*
+     * @param source    source text, must outlive the returned sequences
+     * @param text      text without control sequences is appended to it
+     * @return          all CSI sequences and OSC, position is relative to the appended text
+     *
+     * Invalid or incomplete sequences are kept in text.
+     */
+    static std::vector<CSISequence> scan(std::string_view source, std::string& text);
+
+    // same as above, sequences are appended to seqs, so caller can reuse the vector
+    static void scan(std::string_view source, std::string& text, std::vector<CSISequence>& seqs);
+
+    /*
+     * Remove CSI sequences and OSC, parameters are not parsed and positions are not recorded.
+     *
+     * @param source    source text
+     * @param text      text without control sequences is appended to it
+     */
+    static void strip(std::string_view source, std::string& text);
+
+    /*
+     * Same as above, in place.
+     *
+     * @return          length of the text without control sequences
+     */
+    static size_t strip(char* text, size_t len);
+
+    static void strip(std::string& text);
+
+};
+
+} // namespace ANSI
@@ -0,0 +1,284 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include "CheckpointIndex.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#include "CSIScanner.h"
+#include "TextParser.h"
+
+namespace ANSI {
+
+// bytes at the start and at the end of the indexed text which identify it, a log which is appended to keeps them
+static constexpr size_t FINGERPRINT_SIZE = 4096;
+
+/*
+ * File format, all numbers are little endian:
+ *
+ * header       magic "SGRIDX2\0", lineInterval u64, byteInterval u64, indexedSize u64, fingerprint u64,
+ *              end fingerprint u64, default attribute, checkpoint count u64
+ * checkpoint   line u64, offset u64, attribute
+ * attribute    state u8, front r g b u8, back r g b u8
+ */
+static constexpr char   INDEX_MAGIC[8]      = { 'S', 'G', 'R', 'I', 'D', 'X', '2', '\0' };
+static constexpr size_t ATTR_BYTES          = 7;
+static constexpr size_t HEADER_BYTES        = sizeof(INDEX_MAGIC) + 5 * 8 + ATTR_BYTES + 8;
+static constexpr size_t CHECKPOINT_BYTES    = 2 * 8 + ATTR_BYTES;
+static constexpr size_t MAX_STATE           = size_t(TextAttribute::State::CUSTOM);
+static constexpr size_t INDEX_READ_BUF_SIZE = 64 * 1024;
+
+static void putU64(std::string& out, uint64_t value)
+{
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(char(value >> (i * 8)));
+    }
+}
+
+static void putAttr(std::string& out, const TextAttribute& attr)
+{
+    const auto& front = attr.color.front;
+    const auto& back  = attr.color.back;
+    const char  bytes[ATTR_BYTES] { char(attr.state), char(front.r), char(front.g), char(front.b),
+                                   char(back.r),     char(back.g),  char(back.b) };
+    out.append(bytes, ATTR_BYTES);
+}
+
+static uint64_t getU64(const char* in)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value |= uint64_t(uint8_t(in[i])) << (i * 8);
+    }
+    return value;
+}
+
+// false if the state is unknown
+static bool getAttr(const char* in, TextAttribute& attr)
+{
+    auto byte = [in](int i) { return uint8_t(in[i]); };
+    if (byte(0) > MAX_STATE) {
+        return false;
+    }
+    attr = { TextAttribute::State(byte(0)), { { byte(1), byte(2), byte(3) }, { byte(4), byte(5), byte(6) } } };
+    return true;
+}
+
+CheckpointIndex::CheckpointIndex(const TextAttribute& defaultAttr, const TextAttribute& startAttr,
+                                 uint64_t lineInterval, uint64_t byteInterval)
+    : defaultTextAttr_(defaultAttr)
+    , lineInterval_(lineInterval)
+    , byteInterval_(byteInterval)
+    , indexedSize_(0)
+    , fingerprint_(fingerprintOf({}))
+    , endFingerprint_(endFingerprintOf({}))
+    , checkpoints_ { { 0, 0, startAttr } }
+{
+}
+
+void CheckpointIndex::update(std::string_view data)
+{
+    Checkpoint last = checkpoints_.back();
+    if (last.offset > data.size()) {
+        return;
+    }
+
+    SGRParser sgrParser(defaultTextAttr_);
+    sgrParser.enableCache(true);
+
+    /*
+     * Lines after the last checkpoint were counted but not recorded, count them again. One scan finds the line ends
+     * and composes the transform since the last checkpoint: SGR sequences can not contain '\n', so every line end is
+     * in a text block.
+     */
+    const char*            begin     = data.data();
+    uint64_t               lineCnt   = 0;
+    uint64_t               indexed   = last.offset;
+    TextAttributeTransform transform { 0, defaultTextAttr_ };
+    CSIScanner::visit(
+        data.substr(last.offset),
+        [&](std::string_view text) {
+            const char* cur     = text.data();
+            const char* end     = cur + text.size();
+            const char* newline = nullptr;
+            while ((newline = static_cast<const char*>(std::memchr(cur, '\n', end - cur))) != nullptr) {
+                cur     = newline + 1;
+                indexed = cur - begin;
+                ++lineCnt;
+
+                if ((lineInterval_ != 0 && lineCnt >= lineInterval_)
+                    || (byteInterval_ != 0 && indexed - last.offset >= byteInterval_)) {
+                    last      = { last.line + lineCnt, indexed, transform.apply(last.attr) };
+                    transform = { 0, defaultTextAttr_ };
+                    lineCnt   = 0;
+                    checkpoints_.push_back(last);
+                }
+            }
+        },
+        [&](std::string_view sequence) {
+            CSISequence seq { 0, sequence };
+            if (seq.finalByte() == CSIFinalBytes::SGR) {
+                transform = transform.then(sgrParser.parseSGRTransform(seq.parameters()).second);
+            }
+        });
+
+    indexedSize_    = std::max(indexedSize_, indexed);
+    fingerprint_    = fingerprintOf(data.substr(0, indexedSize_));
+    endFingerprint_ = endFingerprintOf(data.substr(0, indexedSize_));
+}
+
+const Checkpoint& CheckpointIndex::nearest(uint64_t line) const
+{
+    auto it = std::upper_bound(checkpoints_.begin(), checkpoints_.end(), line,
+                               [](uint64_t line, const Checkpoint& checkpoint) { return line < checkpoint.line; });
+    // the first checkpoint is line 0, so it is never the upper bound
+    return *(it - 1);
+}
+
+bool CheckpointIndex::seek(std::string_view data, uint64_t line, Checkpoint& result) const
+{
+    const auto& checkpoint = nearest(line);
+    if (checkpoint.offset > data.size()) {
+        return false;
+    }
+
+    const char* begin = data.data();
+    const char* end   = begin + data.size();
+    const char* cur   = begin + checkpoint.offset;
+    for (uint64_t skip = line - checkpoint.line; skip != 0; --skip) {
+        auto newline = static_cast<const char*>(std::memchr(cur, '\n', end - cur));
+        if (newline == nullptr) {
+            return false;
+        }
+        cur = newline + 1;
+    }
+
+    TextParser parser(defaultTextAttr_, defaultTextAttr_);
+    uint64_t   offset    = cur - begin;
+    auto       transform = parser.transform(data.substr(checkpoint.offset, offset - checkpoint.offset));
+    result               = { line, offset, transform.apply(checkpoint.attr) };
+    return true;
+}
+
+bool CheckpointIndex::matches(std::string_view data) const
+{
+    if (data.size() < indexedSize_) {
+        return false;
+    }
+    auto indexed = data.substr(0, indexedSize_);
+    return fingerprintOf(indexed) == fingerprint_ && endFingerprintOf(indexed) == endFingerprint_;
+}
+
+bool CheckpointIndex::save(const std::string& path) const
+{
+    std::string out;
+    out.reserve(HEADER_BYTES + checkpoints_.size() * CHECKPOINT_BYTES);
+    out.append(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    putU64(out, lineInterval_);
+    putU64(out, byteInterval_);
+    putU64(out, indexedSize_);
+    putU64(out, fingerprint_);
+    putU64(out, endFingerprint_);
+    putAttr(out, defaultTextAttr_);
+    putU64(out, checkpoints_.size());
+    for (const auto& checkpoint : checkpoints_) {
+        putU64(out, checkpoint.line);
+        putU64(out, checkpoint.offset);
+        putAttr(out, checkpoint.attr);
+    }
+
+    // written next to the index and renamed over it, a reader or a crash never sees a half written index
+    auto  tempPath = path + ".tmp";
+    FILE* file     = std::fopen(tempPath.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool written = std::fwrite(out.data(), 1, out.size(), file) == out.size();
+    if (std::fclose(file) != 0 || !written || std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool CheckpointIndex::load(const std::string& path)
+{
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    std::string in;
+    char        buf[INDEX_READ_BUF_SIZE];
+    size_t      len;
+    while ((len = std::fread(buf, 1, sizeof(buf), file)) != 0) {
+        in.append(buf, len);
+    }
+    bool readError = std::ferror(file) != 0;
+    std::fclose(file);
+    if (readError || in.size() < HEADER_BYTES || std::memcmp(in.data(), INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0) {
+        return false;
+    }
+
+    const char*   cur            = in.data() + sizeof(INDEX_MAGIC);
+    uint64_t      lineInterval   = getU64(cur);
+    uint64_t      byteInterval   = getU64(cur + 8);
+    uint64_t      indexedSize    = getU64(cur + 16);
+    uint64_t      fingerprint    = getU64(cur + 24);
+    uint64_t      endFingerprint = getU64(cur + 32);
+    TextAttribute defaultAttr;
+    if (!getAttr(cur + 40, defaultAttr)) {
+        return false;
+    }
+    uint64_t count = getU64(cur + 40 + ATTR_BYTES);
+    if (count == 0 || count > (in.size() - HEADER_BYTES) / CHECKPOINT_BYTES
+        || in.size() != HEADER_BYTES + count * CHECKPOINT_BYTES) {
+        return false;
+    }
+
+    // checkpoints must start from line 0 and be sorted, nearest() relies on it
+    std::vector<Checkpoint> checkpoints(count);
+    cur = in.data() + HEADER_BYTES;
+    for (size_t i = 0; i < count; ++i, cur += CHECKPOINT_BYTES) {
+        auto& checkpoint  = checkpoints[i];
+        checkpoint.line   = getU64(cur);
+        checkpoint.offset = getU64(cur + 8);
+        if (!getAttr(cur + 16, checkpoint.attr) || checkpoint.offset > indexedSize) {
+            return false;
+        }
+        if (i != 0 && (checkpoint.line <= checkpoints[i - 1].line || checkpoint.offset <= checkpoints[i - 1].offset)) {
+            return false;
+        }
+    }
+    if (checkpoints[0].line != 0 || checkpoints[0].offset != 0) {
+        return false;
+    }
+
+    defaultTextAttr_ = defaultAttr;
+    lineInterval_    = lineInterval;
+    byteInterval_    = byteInterval;
+    indexedSize_     = indexedSize;
+    fingerprint_     = fingerprint;
+    endFingerprint_  = endFingerprint;
+    checkpoints_     = std::move(checkpoints);
+    return true;
+}
+
+uint64_t CheckpointIndex::fingerprintOf(std::string_view data)
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (auto ch : data.substr(0, FINGERPRINT_SIZE)) {
+        hash = (hash ^ uint8_t(ch)) * 0x100000001B3ull;
+    }
+    return hash;
+}
+
+uint64_t CheckpointIndex::endFingerprintOf(std::string_view data)
+{
+    return fingerprintOf(data.substr(data.size() - std::min(data.size(), FINGERPRINT_SIZE)));
+}
+
+} // namespace ANSI
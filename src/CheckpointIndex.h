@@ -0,0 +1,111 @@
+//
+// Created by marvin on 26-10-17.
+//
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "SGRParser.h"
+
+namespace ANSI {
+
+// attribute at the start of a line
+struct Checkpoint {
+    uint64_t      line;   // line number, from 0
+    uint64_t      offset; // byte offset of the line in the data
+    TextAttribute attr;
+};
+
+/*
+ * Attribute at the start of every N lines or bytes of a large text, lines are separated by '\n'.
+ *
+ * A line can be parsed from the nearest checkpoint before it instead of from the start of the text:
+ * TextParser parser(defaultAttr, checkpoint.attr). SGR sequences can not contain '\n', so the attribute at a
+ * checkpoint is the TextAttributeTransform of the text since the previous one applied to its attribute, the
+ * text itself is skipped.
+ *
+ * The index can be saved next to the text and loaded again, matches() tells if it still belongs to the text.
+ */
+class CheckpointIndex {
+public:
+    /*
+     * The first checkpoint is line 0 with startAttr.
+     *
+     * @param lineInterval  a checkpoint is added after this many lines, 0 means no line limit
+     * @param byteInterval  or at the first line which starts this many bytes after the previous checkpoint,
+     *                      0 means no byte limit
+     */
+    CheckpointIndex(const TextAttribute& defaultAttr, const TextAttribute& startAttr, uint64_t lineInterval,
+                    uint64_t byteInterval);
+    ~CheckpointIndex() = default;
+
+    CheckpointIndex(const CheckpointIndex&)            = delete;
+    CheckpointIndex(CheckpointIndex&&)                 = delete;
+    CheckpointIndex& operator=(const CheckpointIndex&) = delete;
+    CheckpointIndex& operator=(CheckpointIndex&&)      = delete;
+
+    /*
+     * Index the lines of data after indexedSize(), so a growing log is indexed again only from its last
+     * checkpoint. A line without '\n' at the end is not indexed until it is complete.
+     *
+     * @param data  the whole text, the bytes before indexedSize() must not be changed
+     */
+    void update(std::string_view data);
+
+    // the last checkpoint at or before line
+    const Checkpoint& nearest(uint64_t line) const;
+
+    /*
+     * Offset and attribute of line, the lines after the nearest checkpoint are skipped.
+     *
+     * @param data      the indexed text
+     * @param result    set if found
+     * @return          false if data has no such line
+     */
+    bool seek(std::string_view data, uint64_t line, Checkpoint& result) const;
+
+    /*
+     * True if the index was built from data or a text which data starts with. The first and the last 4 KiB of the
+     * indexed bytes are compared, so a rotated or rewritten log with the same banner is not taken for the old one.
+     */
+    bool matches(std::string_view data) const;
+
+    // file format is little endian, see CheckpointIndex.cpp
+    bool save(const std::string& path) const;
+
+    // the index is not changed if false is returned
+    bool load(const std::string& path);
+
+    // path of the index saved next to a text, example: "app.log" -> "app.log.sgridx"
+    static inline std::string pathOf(const std::string& textPath) { return textPath + ".sgridx"; }
+
+    inline const std::vector<Checkpoint>& checkpoints() const { return checkpoints_; }
+
+    // bytes of complete lines indexed
+    inline uint64_t indexedSize() const { return indexedSize_; }
+
+    inline uint64_t lineInterval() const { return lineInterval_; }
+
+    inline uint64_t byteInterval() const { return byteInterval_; }
+
+private:
+    // FNV-1a of the first 4 KiB
+    static uint64_t fingerprintOf(std::string_view data);
+
+    // FNV-1a of the last 4 KiB
+    static uint64_t endFingerprintOf(std::string_view data);
+
+private:
+    TextAttribute           defaultTextAttr_;
+    uint64_t                lineInterval_;
+    uint64_t                byteInterval_;
+    uint64_t                indexedSize_;
+    uint64_t                fingerprint_;    // of the first bytes
+    uint64_t                endFingerprint_; // of the last indexed bytes
+    std::vector<Checkpoint> checkpoints_;
+};
+
+} // namespace ANSI
@@ -0,0 +1,165 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include "ColorQuantizer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+namespace ANSI {
+
+using Palette = ColorQuantizer::Palette;
+
+static constexpr int CELL_BITS  = 5;
+static constexpr int CELL_SHIFT = 8 - CELL_BITS;
+static constexpr int CELL_SIZE  = 1 << CELL_SHIFT;
+static constexpr int CELL_CNT   = 1 << (CELL_BITS * 3);
+
+struct QuantizeTable {
+    std::vector<uint32_t> cellStart;  // candidates of cell i are [cellStart[i], cellStart[i + 1])
+    std::vector<uint8_t>  candidates; // palette indexes, ascending in every cell
+};
+
+static inline int cellOf(const RGB& rgb)
+{
+    return (rgb.r >> CELL_SHIFT) << (CELL_BITS * 2) | (rgb.g >> CELL_SHIFT) << CELL_BITS | (rgb.b >> CELL_SHIFT);
+}
+
+static inline int distance(const RGB& lhs, const RGB& rhs)
+{
+    int r = lhs.r - rhs.r;
+    int g = lhs.g - rhs.g;
+    int b = lhs.b - rhs.b;
+    return r * r + g * g + b * b;
+}
+
+static QuantizeTable makeTable(int paletteSize)
+{
+    constexpr int CELL_DIM = 1 << CELL_BITS;
+
+    // squared nearest and farthest distance of every palette channel value to every cell range of a channel
+    std::vector<int> near(3 * CELL_DIM * paletteSize);
+    std::vector<int> far(3 * CELL_DIM * paletteSize);
+    for (int channel = 0; channel < 3; ++channel) {
+        for (int k = 0; k < CELL_DIM; ++k) {
+            int lo = k << CELL_SHIFT;
+            int hi = lo + CELL_SIZE - 1;
+            for (int i = 0; i < paletteSize; ++i) {
+                auto rgb   = ColorTable::bit8Color(uint8_t(i));
+                int  value = channel == 0 ? rgb.r : channel == 1 ? rgb.g : rgb.b;
+                int  n     = value < lo ? lo - value : value > hi ? value - hi : 0;
+                int  f     = std::max(std::abs(value - lo), std::abs(value - hi));
+
+                near[(channel * CELL_DIM + k) * paletteSize + i] = n * n;
+                far[(channel * CELL_DIM + k) * paletteSize + i]  = f * f;
+            }
+        }
+    }
+
+    QuantizeTable table;
+    table.cellStart.reserve(CELL_CNT + 1);
+
+    std::vector<int> minDist(paletteSize);
+    for (int cell = 0; cell < CELL_CNT; ++cell) {
+        const int r = cell >> (CELL_BITS * 2);
+        const int g = (cell >> CELL_BITS) & (CELL_DIM - 1);
+        const int b = cell & (CELL_DIM - 1);
+
+        const int* nearR = near.data() + r * paletteSize;
+        const int* nearG = near.data() + (CELL_DIM + g) * paletteSize;
+        const int* nearB = near.data() + (CELL_DIM * 2 + b) * paletteSize;
+        const int* farR  = far.data() + r * paletteSize;
+        const int* farG  = far.data() + (CELL_DIM + g) * paletteSize;
+        const int* farB  = far.data() + (CELL_DIM * 2 + b) * paletteSize;
+
+        // a color can be the nearest one of a point in the cell only if its nearest distance to the cell is not
+        // larger than the farthest distance of another color
+        int threshold = std::numeric_limits<int>::max();
+        for (int i = 0; i < paletteSize; ++i) {
+            minDist[i] = nearR[i] + nearG[i] + nearB[i];
+            threshold  = std::min(threshold, farR[i] + farG[i] + farB[i]);
+        }
+
+        table.cellStart.push_back(uint32_t(table.candidates.size()));
+        for (int i = 0; i < paletteSize; ++i) {
+            if (minDist[i] <= threshold) {
+                table.candidates.push_back(uint8_t(i));
+            }
+        }
+    }
+    table.cellStart.push_back(uint32_t(table.candidates.size()));
+    return table;
+}
+
+static const QuantizeTable& tableOf(Palette palette)
+{
+    if (palette == Palette::COLOR_16) {
+        static const QuantizeTable table16 = makeTable(16);
+        return table16;
+    }
+    static const QuantizeTable table256 = makeTable(256);
+    return table256;
+}
+
+static inline uint8_t nearestIn(const QuantizeTable& table, const RGB& rgb)
+{
+    auto    cell    = cellOf(rgb);
+    auto    begin   = table.cellStart[cell];
+    auto    end     = table.cellStart[cell + 1];
+    uint8_t index   = table.candidates[begin];
+    int     minDist = distance(rgb, ColorTable::bit8Color(index));
+    for (auto i = begin + 1; i < end && minDist != 0; ++i) {
+        auto candidate = table.candidates[i];
+        auto dist      = distance(rgb, ColorTable::bit8Color(candidate));
+        if (dist < minDist) {
+            minDist = dist;
+            index   = candidate;
+        }
+    }
+    return index;
+}
+
+uint8_t ColorQuantizer::nearest(const RGB& rgb, Palette palette)
+{
+    return nearestIn(tableOf(palette), rgb);
+}
+
+void ColorQuantizer::nearest(const RGB* colors, uint8_t* indexes, size_t cnt, Palette palette)
+{
+    const auto& table = tableOf(palette);
+    for (size_t i = 0; i < cnt; ++i) {
+        // runs next to each other often share the color
+        indexes[i] = (i > 0 && colors[i] == colors[i - 1]) ? indexes[i - 1] : nearestIn(table, colors[i]);
+    }
+}
+
+void ColorQuantizer::quantize(TextColorAttr* runs, size_t cnt, Palette palette)
+{
+    const auto& table = tableOf(palette);
+    RGB         lastColor[2] {};
+    RGB         lastResult[2] {};
+    bool        hasLast[2] {};
+    auto        quantizeColor = [&](RGB& rgb, int field) {
+        if (!hasLast[field] || !(rgb == lastColor[field])) {
+            lastColor[field]  = rgb;
+            lastResult[field] = ColorTable::bit8Color(nearestIn(table, rgb));
+            hasLast[field]    = true;
+        }
+        rgb = lastResult[field];
+    };
+
+    for (size_t i = 0; i < cnt; ++i) {
+        quantizeColor(runs[i].color.front, 0);
+        quantizeColor(runs[i].color.back, 1);
+    }
+}
+
+void ColorQuantizer::quantize(ColorfulText& text, Palette palette)
+{
+    quantize(text.color.data(), text.color.size(), palette);
+}
+
+} // namespace ANSI
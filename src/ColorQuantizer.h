@@ -0,0 +1,50 @@
+//
+// Created by marvin on 26-10-17.
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "SGRParser.h"
+#include "TextParser.h"
+
+namespace ANSI {
+
+/*
+ * Map 24-bit colors to the nearest color of the 8-bit palette or of its first 16 colors(ColorTable),
+ * for terminals which do not support 24-bit colors. Distance is the squared RGB distance, the lowest
+ * index wins a tie.
+ *
+ * A 32x32x32 lookup table keeps for every cell the palette colors which can be the nearest one of a color
+ * in the cell, so a lookup compares a few candidates instead of the whole palette. The table of a palette
+ * is built on its first use.
+ */
+class ColorQuantizer {
+public:
+    enum class Palette {
+        COLOR_256, // xterm 256 colors, index of ColorTable::bit8Color
+        COLOR_16,  // 3/4-bit colors, index 0-15 of ColorTable::bit8Color
+    };
+
+public:
+    ColorQuantizer()  = delete;
+    ~ColorQuantizer() = delete;
+
+    // @return          palette index of the nearest color
+    static uint8_t nearest(const RGB& rgb, Palette palette);
+
+    /*
+     * @param colors    colors to quantize
+     * @param indexes   palette index of every color, same size as colors
+     * @param cnt       color count
+     */
+    static void nearest(const RGB* colors, uint8_t* indexes, size_t cnt, Palette palette);
+
+    // replace front and back color of every run by the nearest palette color
+    static void quantize(TextColorAttr* runs, size_t cnt, Palette palette);
+
+    static void quantize(ColorfulText& text, Palette palette);
+};
+
+} // namespace ANSI
@@ -0,0 +1,112 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include "HTMLRenderer.h"
+
+#include "SIMD.h"
+
+namespace ANSI {
+
+static constexpr std::string_view SPAN_END = "</span>";
+
+HTMLRenderer::HTMLRenderer(const TextAttribute& defaultTextAttr, const TextAttribute& currentTextAttr)
+    : parser_(defaultTextAttr, currentTextAttr)
+    , spanOpen_(false)
+    , spanAttr_(currentTextAttr)
+{
+}
+
+void HTMLRenderer::render(std::string_view chunk, std::string& out)
+{
+    parser_.parse(chunk, [this, &out](std::string_view text, const TextAttribute& attr) {
+        renderText(text, attr, out);
+    });
+}
+
+void HTMLRenderer::finish(std::string& out)
+{
+    parser_.finish([this, &out](std::string_view text, const TextAttribute& attr) {
+        renderText(text, attr, out);
+    });
+    if (spanOpen_) {
+        out += SPAN_END;
+        spanOpen_ = false;
+    }
+}
+
+void HTMLRenderer::renderText(std::string_view text, const TextAttribute& attr, std::string& out)
+{
+    if (text.empty()) {
+        return;
+    }
+
+    // only change the span when the attribute of the text is changed
+    bool custom = attr.state == TextAttribute::State::CUSTOM;
+    if (spanOpen_ && (!custom || attr != spanAttr_)) {
+        out += SPAN_END;
+        spanOpen_ = false;
+    }
+    if (custom && !spanOpen_) {
+        appendSpan(attr, out);
+        spanOpen_ = true;
+        spanAttr_ = attr;
+    }
+
+    escape(text, out);
+}
+
+void HTMLRenderer::appendSpan(const TextAttribute& attr, std::string& out)
+{
+    constexpr char hex[] = "0123456789abcdef";
+    auto appendRGB       = [&out, &hex](const RGB& rgb) {
+        for (auto value : { rgb.r, rgb.g, rgb.b }) {
+            out += hex[value >> 4];
+            out += hex[value & 0x0f];
+        }
+    };
+
+    out += "<span style=\"color:#";
+    appendRGB(attr.color.front);
+    out += ";background-color:#";
+    appendRGB(attr.color.back);
+    out += "\">";
+}
+
+void HTMLRenderer::escape(std::string_view text, std::string& out)
+{
+    const char* cur  = text.data();
+    const char* last = cur + text.size();
+    while (cur != last) {
+        // copy the plain block in one go
+        const char* special = SIMD::findHTMLSpecial(cur, last);
+        out.append(cur, special - cur);
+        if (special == last) {
+            break;
+        }
+
+        switch (*special) {
+        case '<':
+            out += "&lt;";
+            break;
+        case '>':
+            out += "&gt;";
+            break;
+        case '&':
+            out += "&amp;";
+            break;
+        case '"':
+            out += "&quot;";
+            break;
+        case '\'':
+            out += "&#39;";
+            break;
+        default:
+            // control byte, dropped
+            break;
+        }
+        cur = special + 1;
+    }
+}
+
+} // namespace ANSI
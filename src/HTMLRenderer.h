@@ -0,0 +1,70 @@
+//
+// Created by marvin on 26-10-17.
+//
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "SGRStreamParser.h"
+
+namespace ANSI {
+
+/*
+ * Render a byte stream with SGR sequences to HTML, for example inside <pre>.
+ *
+ * Text is escaped, custom text is wrapped in <span style="color:#rrggbb;background-color:#rrggbb">.
+ * A span is only closed when the next text has another attribute, so sequences which do not change the
+ * attribute do not split it. Other control sequences are removed, and so are the ESC of sequences which are not
+ * valid and other control bytes, a browser would show them as replacement characters.
+ * Memory does not depend on the stream length, HTML is appended to a buffer of the caller.
+ */
+class HTMLRenderer {
+public:
+    HTMLRenderer(const TextAttribute& defaultTextAttr, const TextAttribute& currentTextAttr);
+    ~HTMLRenderer() = default;
+
+    HTMLRenderer(const HTMLRenderer&)            = delete;
+    HTMLRenderer(HTMLRenderer&&)                 = delete;
+    HTMLRenderer& operator=(const HTMLRenderer&) = delete;
+    HTMLRenderer& operator=(HTMLRenderer&&)      = delete;
+
+    /*
+     * @param chunk     bytes of the stream, can be split at any position
+     * @param out       HTML of the chunk is appended, caller can write and clear it between calls
+     */
+    void render(std::string_view chunk, std::string& out);
+
+    // end of stream, an unfinished sequence is rendered as text and the open span is closed
+    void finish(std::string& out);
+
+    inline const TextAttribute& currentTextAttr() const { return parser_.currentTextAttr(); }
+
+    // the span of the text rendered last is not closed yet, its attribute is spanAttr()
+    inline bool spanOpen() const { return spanOpen_; }
+
+    inline const TextAttribute& spanAttr() const { return spanAttr_; }
+
+    /*
+     * Text which is parsed already, example: the text of TextParser::visit, so a caller which has the whole
+     * input can parse it with the scanner of the other formats. It can be mixed with render().
+     *
+     * @param text      text without control sequences
+     * @param attr      attribute of the text
+     * @param out       HTML of the text is appended
+     */
+    void renderText(std::string_view text, const TextAttribute& attr, std::string& out);
+
+    // append text with < > & " ' replaced by entities, control bytes other than \t \n \r and DEL are dropped
+    static void escape(std::string_view text, std::string& out);
+
+private:
+    static void appendSpan(const TextAttribute& attr, std::string& out);
+
+private:
+    SGRStreamParser parser_;
+    bool            spanOpen_;
+    TextAttribute   spanAttr_; // attribute of the open span
+};
+
+} // namespace ANSI
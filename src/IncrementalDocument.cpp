@@ -0,0 +1,72 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include "IncrementalDocument.h"
+
+#include <cstring>
+
+namespace ANSI {
+
+IncrementalDocument::IncrementalDocument(const TextAttribute& defaultAttr, const TextAttribute& currentAttr,
+                                         TextParser::Mode mode)
+    : parser_(defaultAttr, currentAttr)
+    , mode_(mode)
+{
+}
+
+IncrementalDocument::Change IncrementalDocument::append(std::string_view data)
+{
+    if (data.empty()) {
+        return { size(), 0 };
+    }
+
+    size_t      firstLine = lines_.size();
+    const char* cur       = data.data();
+    const char* last      = cur + data.size();
+    const char* newline   = nullptr;
+    while ((newline = static_cast<const char*>(std::memchr(cur, '\n', last - cur))) != nullptr) {
+        std::string_view line { cur, size_t(newline - cur) };
+        if (partial_.empty()) {
+            parser_.parse(line, lines_, mode_);
+        }
+        else {
+            partial_.append(line);
+            parser_.parse(partial_, lines_, mode_);
+            partial_.clear();
+        }
+        cur = newline + 1;
+    }
+    partial_.append(cur, last - cur);
+    parsePartialLine();
+
+    return { firstLine, size() - firstLine };
+}
+
+ColorfulTextView IncrementalDocument::operator[](size_t line) const
+{
+    if (line < lines_.size()) {
+        return lines_[line];
+    }
+    return { partialText_.text, partialText_.color.data(), partialText_.color.size() };
+}
+
+void IncrementalDocument::clear()
+{
+    lines_.clear();
+    partial_.clear();
+    partialText_.text.clear();
+    partialText_.color.clear();
+}
+
+void IncrementalDocument::parsePartialLine()
+{
+    // the attribute of the complete lines must not be changed by the bytes which are parsed again later
+    TextParser parser(parser_.sgrParser().defaultTextAttr(), parser_.currentTextAttr());
+    parser.enableCoalesce(parser_.coalesce());
+
+    std::string_view partial { partial_ };
+    partialText_ = parser.parse(partial.substr(0, partial.size() - CSIScanner::incompleteLen(partial)), mode_);
+}
+
+} // namespace ANSI
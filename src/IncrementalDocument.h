@@ -0,0 +1,77 @@
+//
+// Created by marvin on 26-10-17.
+//
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "TextParser.h"
+
+namespace ANSI {
+
+/*
+ * Lines of a growing text, example: a tailed log. Only appended bytes are parsed.
+ *
+ * Complete lines are parsed once into a ColorfulTextBuffer and the parser keeps the attribute at the end of the
+ * last one. The bytes after the last '\n' are kept and the last line is parsed again from them when more bytes come,
+ * so a sequence cut by an append is parsed once it is complete. Until then it is not shown.
+ *
+ * Cost of append() is the appended bytes plus the last line, not the document.
+ */
+class IncrementalDocument {
+public:
+    // lines firstLine ... firstLine + lineCnt - 1 were added or changed, lines before them are not changed
+    struct Change {
+        size_t firstLine;
+        size_t lineCnt;
+    };
+
+public:
+    IncrementalDocument(const TextAttribute& defaultAttr, const TextAttribute& currentAttr,
+                        TextParser::Mode mode = TextParser::Mode::ALL_TEXT);
+    ~IncrementalDocument() = default;
+
+    IncrementalDocument(const IncrementalDocument&)            = delete;
+    IncrementalDocument(IncrementalDocument&&)                 = delete;
+    IncrementalDocument& operator=(const IncrementalDocument&) = delete;
+    IncrementalDocument& operator=(IncrementalDocument&&)      = delete;
+
+    /*
+     * @param data  bytes appended to the text, lines are separated by '\n'
+     * @return      lines to repaint, only the last line before data can change
+     */
+    Change append(std::string_view data);
+
+    // complete lines and the last line if it is not complete
+    inline size_t size() const { return lines_.size() + (partial_.empty() ? 0 : 1); }
+
+    inline bool empty() const { return size() == 0; }
+
+    // line of the document, valid until the next append()
+    ColorfulTextView operator[](size_t line) const;
+
+    // true if the last line is not ended by '\n' yet
+    inline bool hasPartialLine() const { return !partial_.empty(); }
+
+    // lines are removed, the attribute is kept
+    void clear();
+
+    // attribute at the end of the last complete line
+    inline const TextAttribute& currentTextAttr() const { return parser_.currentTextAttr(); }
+
+    // parser of the complete lines, example: enable its SGR cache
+    inline TextParser& parser() { return parser_; }
+
+private:
+    void parsePartialLine();
+
+private:
+    TextParser         parser_;
+    TextParser::Mode   mode_;
+    ColorfulTextBuffer lines_;
+    std::string        partial_;     // bytes after the last '\n'
+    ColorfulText       partialText_; // parse result of partial_
+};
+
+} // namespace ANSI
@@ -0,0 +1,72 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include "SGRCache.h"
+
+#include <cstring>
+
+namespace ANSI {
+
+static constexpr uint8_t EMPTY_SLOT = SGRCache::MAX_KEY_LEN + 1;
+
+SGRCache::SGRCache()
+    : slots_()
+    , hits_(0)
+    , misses_(0)
+{
+    clear();
+}
+
+// FNV-1a, parameters are only a few bytes
+size_t SGRCache::slotOf(std::string_view parameters)
+{
+    uint32_t hash = 2166136261u;
+    for (auto ch : parameters) {
+        hash ^= static_cast<uint8_t>(ch);
+        hash *= 16777619u;
+    }
+    return (hash ^ (hash >> 16)) & (SLOT_CNT - 1);
+}
+
+bool SGRCache::find(std::string_view parameters, SGRParser::SGRTransformReturn& result)
+{
+    if (parameters.size() > MAX_KEY_LEN) {
+        ++misses_;
+        return false;
+    }
+
+    const auto& slot = slots_[slotOf(parameters)];
+    if (slot.len != parameters.size() || std::memcmp(slot.key, parameters.data(), parameters.size()) != 0) {
+        ++misses_;
+        return false;
+    }
+
+    ++hits_;
+    result = slot.result;
+    return true;
+}
+
+void SGRCache::insert(std::string_view parameters, const SGRParser::SGRTransformReturn& result)
+{
+    if (parameters.size() > MAX_KEY_LEN) {
+        return;
+    }
+
+    // replace the old entry of the slot
+    auto& slot = slots_[slotOf(parameters)];
+    slot.len   = static_cast<uint8_t>(parameters.size());
+    std::memcpy(slot.key, parameters.data(), parameters.size());
+    slot.result = result;
+}
+
+void SGRCache::clear()
+{
+    for (auto& slot : slots_) {
+        slot.len = EMPTY_SLOT;
+    }
+    hits_   = 0;
+    misses_ = 0;
+}
+
+} // namespace ANSI
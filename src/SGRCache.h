@@ -0,0 +1,58 @@
+//
+// Created by marvin on 26-10-17.
+//
+#pragma once
+
+#include <array>
+#include <string_view>
+
+#include "SGRParser.h"
+
+namespace ANSI {
+
+/*
+ * Direct-mapped cache of parsed SGR parameters.
+ *
+ * The value is a TextAttributeTransform, which does not depend on the current attribute,
+ * so the parameter bytes alone are the key. Longer parameters are not cached.
+ */
+class SGRCache {
+public:
+    static constexpr size_t SLOT_CNT    = 64;
+    static constexpr size_t MAX_KEY_LEN = 31;
+
+public:
+    SGRCache();
+    ~SGRCache() = default;
+
+    /*
+     * @param parameters    SGR parameter bytes, example: "1;31"
+     * @param result        parse result, set if found
+     * @return              true if found
+     */
+    bool find(std::string_view parameters, SGRParser::SGRTransformReturn& result);
+
+    void insert(std::string_view parameters, const SGRParser::SGRTransformReturn& result);
+
+    void clear();
+
+    inline size_t hits() const { return hits_; }
+
+    inline size_t misses() const { return misses_; }
+
+private:
+    struct Slot {
+        uint8_t                       len; // key length, MAX_KEY_LEN + 1 means empty slot
+        char                          key[MAX_KEY_LEN];
+        SGRParser::SGRTransformReturn result;
+    };
+
+    static size_t slotOf(std::string_view parameters);
+
+private:
+    std::array<Slot, SLOT_CNT> slots_;
+    size_t                     hits_;
+    size_t                     misses_;
+};
+
+} // namespace ANSI
@@ -0,0 +1,223 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include "SGREncoder.h"
+
+#include <array>
+
+namespace ANSI {
+
+// how a color field is written
+enum class FieldCode {
+    KEEP,    // not written, the color is not changed
+    DEFAULT, // 39 or 49, state is not changed
+    COLOR,   // 4-bit, 8-bit or 24-bit color, state becomes CUSTOM
+};
+
+// parameter bytes of a sequence, the longest is a reset and two 24-bit colors
+class Parameters {
+public:
+    inline size_t size() const { return len_; }
+
+    inline std::string_view view() const { return { buf_.data(), len_ }; }
+
+    // separator is added before all parameters but the first
+    inline void add(std::string_view parameter)
+    {
+        if (cnt_++ > 0) {
+            buf_[len_++] = static_cast<char>(CSIParameterBytes::PARA_SEPARATOR);
+        }
+        for (auto ch : parameter) {
+            buf_[len_++] = ch;
+        }
+    }
+
+private:
+    std::array<char, 48> buf_ {};
+    size_t               len_ = 0;
+    size_t               cnt_ = 0;
+};
+
+// decimal digits of num, buf is at least 3 bytes
+static std::string_view toDecimal(uint8_t num, char* buf)
+{
+    char* end = buf + 3;
+    char* cur = end;
+    do {
+        *--cur = char('0' + num % 10);
+        num /= 10;
+    } while (num != 0);
+    return { cur, size_t(end - cur) };
+}
+
+// palette index of rgb, -1 if rgb is not in the palette
+static int paletteIndex(const RGB& rgb)
+{
+    // 4-bit colors first, their codes are the shortest
+    for (int i = 0; i < 16; ++i) {
+        if (ColorTable::bit8Color(uint8_t(i)) == rgb) {
+            return i;
+        }
+    }
+
+    // 216 colors, levels 0, 95, 135, 175, 215, 255
+    auto level = [](uint8_t value) {
+        if (value == 0) {
+            return 0;
+        }
+        return (value >= 95 && (value - 95) % 40 == 0) ? (value - 55) / 40 : -1;
+    };
+    int r = level(rgb.r);
+    int g = level(rgb.g);
+    int b = level(rgb.b);
+    if (r >= 0 && g >= 0 && b >= 0) {
+        return 16 + r * 36 + g * 6 + b;
+    }
+
+    // grayscale colors 8, 18, ..., 238
+    if (rgb.r == rgb.g && rgb.g == rgb.b && rgb.r >= 8 && rgb.r <= 238 && (rgb.r - 8) % 10 == 0) {
+        return 232 + (rgb.r - 8) / 10;
+    }
+    return -1;
+}
+
+/*
+ * @param rgb       color
+ * @param front     front or back color
+ * @param params    shortest color parameters are added
+ */
+static void addColor(const RGB& rgb, bool front, Parameters& params)
+{
+    char buf[3];
+    int  index = paletteIndex(rgb);
+    if (index >= 0 && index < 16) {
+        auto base = front ? (index < 8 ? ColorTable::F_BLACK : ColorTable::F_BRIGHT_BLACK - 8)
+                          : (index < 8 ? ColorTable::B_BLACK : ColorTable::B_BRIGHT_BLACK - 8);
+        params.add(toDecimal(uint8_t(base + index), buf));
+        return;
+    }
+
+    params.add(toDecimal(front ? ColorTable::F_CUSTOM_COLOR : ColorTable::B_CUSTOM_COLOR, buf));
+    if (index >= 0) {
+        params.add("5");
+        params.add(toDecimal(uint8_t(index), buf));
+        return;
+    }
+    params.add("2");
+    params.add(toDecimal(rgb.r, buf));
+    params.add(toDecimal(rgb.g, buf));
+    params.add(toDecimal(rgb.b, buf));
+}
+
+SGREncoder::SGREncoder(const TextAttribute& defaultTextAttr, const TextAttribute& currentTextAttr)
+    : defaultTextAttr_ { TextAttribute::State::DEFAULT, defaultTextAttr.color }
+    , currentTextAttr_(currentTextAttr)
+{
+}
+
+void SGREncoder::encode(std::string_view text, const TextAttribute& attr, std::string& out)
+{
+    encodeTransition(currentTextAttr_, attr, out);
+    currentTextAttr_ = attr;
+    out.append(text.data(), text.size());
+}
+
+void SGREncoder::encode(const CompactText& text, const AttributeTable& table, std::string& out)
+{
+    std::string_view view(text.text);
+    size_t           pos = 0;
+    for (const auto& run : text.runs) {
+        if (pos < run.start) {
+            encode(view.substr(pos, run.start - pos), defaultTextAttr_, out);
+        }
+        encode(view.substr(run.start, run.len), table.resolve(run.attrId), out);
+        pos = run.start + run.len;
+    }
+    if (pos < view.size()) {
+        encode(view.substr(pos), defaultTextAttr_, out);
+    }
+}
+
+void SGREncoder::encodeTransition(const TextAttribute& from, const TextAttribute& to, std::string& out) const
+{
+    if (from == to) {
+        return;
+    }
+
+    constexpr FieldCode codes[] { FieldCode::KEEP, FieldCode::DEFAULT, FieldCode::COLOR };
+    const auto&         defaultColor = defaultTextAttr_.color;
+
+    // color parameters do not depend on the candidate, so they are found once
+    Parameters frontColor;
+    Parameters backColor;
+    addColor(to.color.front, true, frontColor);
+    addColor(to.color.back, false, backColor);
+    auto codeSize = [](FieldCode code, const Parameters& color) -> size_t {
+        return code == FieldCode::KEEP ? 0 : code == FieldCode::DEFAULT ? 2 : color.size();
+    };
+
+    // try every code of both fields, with and without a reset before them
+    bool      found     = false;
+    bool      bestReset = false;
+    FieldCode bestFront = FieldCode::KEEP;
+    FieldCode bestBack  = FieldCode::KEEP;
+    size_t    bestSize  = 0;
+    for (bool keepState : { true, false }) {
+        for (bool reset : { false, true }) {
+            const auto& base = reset ? defaultTextAttr_ : from;
+            for (auto front : codes) {
+                for (auto back : codes) {
+                    if ((front == FieldCode::KEEP && base.color.front != to.color.front)
+                        || (back == FieldCode::KEEP && base.color.back != to.color.back)
+                        || (front == FieldCode::DEFAULT && to.color.front != defaultColor.front)
+                        || (back == FieldCode::DEFAULT && to.color.back != defaultColor.back)) {
+                        continue;
+                    }
+                    // nothing written is no sequence
+                    if (!reset && front == FieldCode::KEEP && back == FieldCode::KEEP) {
+                        continue;
+                    }
+                    bool custom = front == FieldCode::COLOR || back == FieldCode::COLOR;
+                    auto state  = custom ? TextAttribute::State::CUSTOM : base.state;
+                    if (keepState && state != to.state) {
+                        continue;
+                    }
+
+                    // reset is an empty first parameter, parameters are separated by one byte
+                    size_t cnt  = size_t(reset) + size_t(front != FieldCode::KEEP) + size_t(back != FieldCode::KEEP);
+                    size_t size = codeSize(front, frontColor) + codeSize(back, backColor) + cnt - 1;
+                    if (!found || size < bestSize) {
+                        found     = true;
+                        bestReset = reset;
+                        bestFront = front;
+                        bestBack  = back;
+                        bestSize  = size;
+                    }
+                }
+            }
+        }
+        // the state of to can not be produced, write its colors
+        if (found) {
+            break;
+        }
+    }
+
+    Parameters best;
+    if (bestReset) {
+        best.add({});
+    }
+    if (bestFront != FieldCode::KEEP) {
+        best.add(bestFront == FieldCode::DEFAULT ? "39" : frontColor.view());
+    }
+    if (bestBack != FieldCode::KEEP) {
+        best.add(bestBack == FieldCode::DEFAULT ? "49" : backColor.view());
+    }
+
+    out += static_cast<char>(SequenceFirst::EXC);
+    out += static_cast<char>(SequenceSecond::CSI);
+    out.append(best.view().data(), best.size());
+    out += static_cast<char>(CSIFinalBytes::SGR);
+}
+
+} // namespace ANSI
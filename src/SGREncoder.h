@@ -0,0 +1,66 @@
+//
+// Created by marvin on 26-10-17.
+//
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "AttributeTable.h"
+#include "SGRParser.h"
+#include "TextParser.h"
+
+namespace ANSI {
+
+/*
+ * Inverse of SGRParser: write text runs with the shortest SGR sequences which SGRParser parses back
+ * to the same attributes.
+ *
+ * Only the fields which change are written, "39"/"49" are used for default colors, and colors of the
+ * 8-bit palette are written as 4-bit or 8-bit codes. A reset is used when it is shorter.
+ * A default state with colors which are not the default ones can not be produced by any sequence,
+ * such an attribute is written with its colors and state CUSTOM.
+ */
+class SGREncoder {
+public:
+    SGREncoder(const TextAttribute& defaultTextAttr, const TextAttribute& currentTextAttr);
+    ~SGREncoder() = default;
+
+    SGREncoder(const SGREncoder&)            = delete;
+    SGREncoder(SGREncoder&&)                 = delete;
+    SGREncoder& operator=(const SGREncoder&) = delete;
+    SGREncoder& operator=(SGREncoder&&)      = delete;
+
+    /*
+     * @param text      text of the run
+     * @param attr      attribute of the run
+     * @param out       sequence from currentTextAttr() to attr and text are appended
+     */
+    void encode(std::string_view text, const TextAttribute& attr, std::string& out);
+
+    /*
+     * Inverse of TextParser::parse(string, table, mode), text outside of the runs has the default attribute.
+     *
+     * @param text      parse result
+     * @param table     attribute table of the runs
+     * @param out       encoded line is appended
+     */
+    void encode(const CompactText& text, const AttributeTable& table, std::string& out);
+
+    /*
+     * @param from      attribute before the sequence
+     * @param to        attribute after the sequence
+     * @param out       shortest sequence is appended, nothing if from equals to
+     */
+    void encodeTransition(const TextAttribute& from, const TextAttribute& to, std::string& out) const;
+
+    inline const TextAttribute& currentTextAttr() const { return currentTextAttr_; }
+
+    inline const TextAttribute& defaultTextAttr() const { return defaultTextAttr_; }
+
+private:
+    TextAttribute defaultTextAttr_;
+    TextAttribute currentTextAttr_;
+};
+
+} // namespace ANSI
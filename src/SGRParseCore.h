@@ -0,0 +1,683 @@
+//
+// Created by marvin on 26-10-17.
+//
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <utility>
+
+#include "ANSI.h"
+
+/*
+ * Header-only part of the parser: text attribute model, SGR parameter state machine and color tables.
+ *
+ * Everything is constexpr, so sequences known at compile time can be parsed by the compiler,
+ * and the parser can be used without linking the library.
+ */
+namespace ANSI {
+
+struct RGB {
+    uint8_t r, g, b;
+};
+
+struct Color {
+    RGB front;
+    RGB back;
+};
+
+struct TextAttribute {
+    enum class State {
+        DEFAULT,
+        CUSTOM,
+    };
+
+    State state;
+    Color color;
+};
+
+constexpr bool operator==(const RGB& lhs, const RGB& rhs)
+{
+    return lhs.r == rhs.r && lhs.g == rhs.g && lhs.b == rhs.b;
+}
+
+constexpr bool operator!=(const RGB& lhs, const RGB& rhs) { return !(lhs == rhs); }
+
+constexpr bool operator==(const Color& lhs, const Color& rhs) { return lhs.front == rhs.front && lhs.back == rhs.back; }
+
+constexpr bool operator!=(const Color& lhs, const Color& rhs) { return !(lhs == rhs); }
+
+constexpr bool operator==(const TextAttribute& lhs, const TextAttribute& rhs)
+{
+    return lhs.state == rhs.state && lhs.color == rhs.color;
+}
+
+constexpr bool operator!=(const TextAttribute& lhs, const TextAttribute& rhs) { return !(lhs == rhs); }
+
+/*
+ * Effect of SGR sequences on a text attribute: every field is either kept or set to a value.
+ *
+ * It does not depend on the attribute it is applied to, and composition is associative,
+ * so the effect of a text can be computed before the attribute at its start is known.
+ */
+struct TextAttributeTransform {
+    enum Field : uint8_t {
+        FIELD_STATE = 0x01,
+        FIELD_FRONT = 0x02,
+        FIELD_BACK  = 0x04,
+    };
+
+    uint8_t       mask; // fields set by the transform
+    TextAttribute value;
+
+    constexpr TextAttribute apply(const TextAttribute& attr) const
+    {
+        return { (mask & FIELD_STATE) ? value.state : attr.state,
+                 { (mask & FIELD_FRONT) ? value.color.front : attr.color.front,
+                   (mask & FIELD_BACK) ? value.color.back : attr.color.back } };
+    }
+
+    // this transform, then next
+    constexpr TextAttributeTransform then(const TextAttributeTransform& next) const
+    {
+        return { uint8_t(mask | next.mask), next.apply(value) };
+    }
+};
+
+class SGRParseCore {
+    friend class ColorTable;
+
+public:
+    enum class ReturnVal {
+        RETURN_SUCCESS_BREAK,
+        RETURN_SUCCESS_CONTINUE,
+
+        RETURN_ERROR_BREAK,
+        RETURN_ERROR_CONTINUE,
+    };
+
+    enum class ParseResult {
+        RESULT_UNSUPPORTED_ATTR,
+        RESULT_FRONT_COLOR,
+        RESULT_BACK_COLOR,
+        RESULT_DEFAULT_FRONT_COLOR,
+        RESULT_DEFAULT_BACK_COLOR,
+        RESULT_DEFAULT_TEXT_ATTR,
+        RESULT_CURRENT_TEXT_ATTR,
+    };
+
+private:
+    enum class ColorVersion : uint8_t {
+        BIT_8  = 5,
+        BIT_24 = 2,
+    };
+
+    enum class ParseState {
+        STATE_WAIT_FIRST_PARAMETER,
+        STATE_WAIT_VERSION,
+        STATE_WAIT_BIT_8_ARGS,
+        STATE_WAIT_BIT_24_ARGS_R,
+        STATE_WAIT_BIT_24_ARGS_G,
+        STATE_WAIT_BIT_24_ARGS_B,
+    };
+
+public:
+    constexpr SGRParseCore()
+        : result_(ParseResult::RESULT_CURRENT_TEXT_ATTR)
+        , state_(ParseState::STATE_WAIT_FIRST_PARAMETER)
+        , color_()
+        , bit24Valid_(true)
+    {
+    }
+    ~SGRParseCore() = default;
+
+    SGRParseCore(const SGRParseCore&)            = default;
+    SGRParseCore(SGRParseCore&&)                 = default;
+    SGRParseCore& operator=(const SGRParseCore&) = default;
+    SGRParseCore& operator=(SGRParseCore&&)      = default;
+
+    // parse parameters until a result is finished, seqs is terminated by "m"
+    constexpr ReturnVal parse(std::string_view& seqs);
+
+    // parse one parameter
+    constexpr ReturnVal parseParameter(std::string_view num);
+
+    constexpr void reset() { *this = SGRParseCore(); }
+
+    constexpr ParseResult result() const { return result_; }
+
+    constexpr RGB color() const { return color_; }
+
+private:
+    constexpr SGRParseCore(ParseResult result, RGB rgb, ParseState s = ParseState::STATE_WAIT_FIRST_PARAMETER)
+        : result_(result)
+        , state_(s)
+        , color_(rgb)
+        , bit24Valid_(true)
+    {
+    }
+
+    constexpr ReturnVal stringToParameter(const std::string_view& in, uint8_t& out);
+
+    constexpr ReturnVal setFirstParameter(const std::string_view& num);
+    constexpr ReturnVal setColorVersion(const std::string_view& num);
+    constexpr ReturnVal setBit8Color(const std::string_view& num);
+    constexpr ReturnVal setBit24Color(const std::string_view& num);
+    constexpr void      setBit24ColorValue(uint8_t num);
+
+private:
+    ParseResult result_;
+    ParseState  state_;
+    RGB         color_;
+    bool        bit24Valid_;
+};
+
+class ColorTable {
+public:
+    enum ColorIndex : uint8_t {
+        RESET_DEFAULT = 0,
+
+        // 3/4-bit front color
+        F_BLACK   = 30,
+        F_RED     = 31,
+        F_GREEN   = 32,
+        F_YELLOW  = 33,
+        F_BLUE    = 34,
+        F_MAGENTA = 35,
+        F_CYAN    = 36,
+        F_WHITE   = 37,
+
+        // custom front color
+        F_CUSTOM_COLOR  = 38,
+        // default front color
+        F_DEFAULT_COLOR = 39,
+
+        // 3/4-bit back color
+        B_BLACK   = 40,
+        B_RED     = 41,
+        B_GREEN   = 42,
+        B_YELLOW  = 43,
+        B_BLUE    = 44,
+        B_MAGENTA = 45,
+        B_CYAN    = 46,
+        B_WHITE   = 47,
+
+        // custom back color
+        B_CUSTOM_COLOR  = 48,
+        // default back color
+        B_DEFAULT_COLOR = 49,
+
+        // 3/4-bit front bright color
+        F_BRIGHT_BLACK   = 90,
+        F_BRIGHT_RED     = 91,
+        F_BRIGHT_GREEN   = 92,
+        F_BRIGHT_YELLOW  = 93,
+        F_BRIGHT_BLUE    = 94,
+        F_BRIGHT_MAGENTA = 95,
+        F_BRIGHT_CYAN    = 96,
+        F_BRIGHT_WHITE   = 97,
+
+        // 3/4-bit back bright color
+        B_BRIGHT_BLACK   = 100,
+        B_BRIGHT_RED     = 101,
+        B_BRIGHT_GREEN   = 102,
+        B_BRIGHT_YELLOW  = 103,
+        B_BRIGHT_BLUE    = 104,
+        B_BRIGHT_MAGENTA = 105,
+        B_BRIGHT_CYAN    = 106,
+        B_BRIGHT_WHITE   = 107,
+    };
+
+    using ColorTableArray = std::array<SGRParseCore, 256>;
+    using PaletteArray    = std::array<RGB, 256>;
+
+public:
+    // parse result of the first parameter, parameter without color is RESULT_UNSUPPORTED_ATTR
+    static constexpr SGRParseCore index(ColorIndex num);
+
+    // reference: https://en.wikipedia.org/wiki/ANSI_escape_code#8-bit
+    static constexpr RGB bit8Color(uint8_t num);
+
+private:
+    static constexpr ColorTableArray makeColorTable();
+    static constexpr PaletteArray    makePalette(const ColorTableArray& colorTable);
+
+private:
+    static const ColorTableArray colorTable;
+    static const PaletteArray    palette;
+};
+
+enum class ConvertRet {
+    NOT_U8  = -2,
+    NOT_NUM = -1,
+    SUCCESS = 0,
+};
+
+constexpr std::pair<ConvertRet, uint8_t> base10ToU8(const std::string_view& num)
+{
+    bool has   = false;
+    int  value = 0;
+
+    for (auto ch : num) {
+        if (ch > '9' || ch < '0') {
+            has = false;
+            break;
+        }
+
+        // stop at the first value out of range, so long numbers do not overflow
+        if (value <= std::numeric_limits<uint8_t>::max()) {
+            value *= 10;
+            value += (ch - '0');
+        }
+        has = true;
+    }
+
+    if (has) {
+        if (value > std::numeric_limits<uint8_t>::max()) {
+            return { ConvertRet::NOT_U8, {} };
+        }
+        return { ConvertRet::SUCCESS, static_cast<uint8_t>(value) };
+    }
+    return { ConvertRet::NOT_NUM, {} };
+}
+
+constexpr SGRParseCore::ReturnVal SGRParseCore::stringToParameter(const std::string_view& in, uint8_t& out)
+{
+    auto [ret, value] = base10ToU8(in);
+    // not number parse break, keep current text attribute
+    if (ret == ConvertRet::NOT_NUM) {
+        result_ = ParseResult ::RESULT_CURRENT_TEXT_ATTR;
+        return ReturnVal::RETURN_ERROR_BREAK;
+    }
+    // not u8 parse continue, use last parse result
+    else if (ret == ConvertRet::NOT_U8) {
+        state_ = ParseState::STATE_WAIT_FIRST_PARAMETER;
+        return ReturnVal::RETURN_ERROR_CONTINUE;
+    }
+    out = value;
+    return ReturnVal::RETURN_SUCCESS_CONTINUE;
+}
+
+constexpr SGRParseCore::ReturnVal SGRParseCore::setFirstParameter(const std::string_view& num)
+{
+    // in the first parameter, the default value is 0, which will reset all text attributes.
+    if (num.empty()) {
+        result_ = ParseResult::RESULT_DEFAULT_TEXT_ATTR;
+        return ReturnVal::RETURN_SUCCESS_BREAK;
+    }
+
+    uint8_t value = 0;
+    auto    ret   = stringToParameter(num, value);
+    if (ret != ReturnVal::RETURN_SUCCESS_CONTINUE) {
+        return ret;
+    }
+
+    *this = ColorTable::index(ColorTable::ColorIndex(value));
+    // UNKNOWN is not support, so continue
+    if (result_ == ParseResult::RESULT_UNSUPPORTED_ATTR) {
+        return ReturnVal::RETURN_ERROR_CONTINUE;
+    }
+
+    // when index valid result, state is STATE_WAIT_FIRST_PARAMETER,
+    return (state_ == ParseState::STATE_WAIT_FIRST_PARAMETER ? ReturnVal::RETURN_SUCCESS_BREAK
+                                                             : ReturnVal::RETURN_SUCCESS_CONTINUE);
+}
+
+constexpr SGRParseCore::ReturnVal SGRParseCore::setColorVersion(const std::string_view& num)
+{
+    // before version parameter is 38, empty parameter will reset parse state, and use last color
+    if (num.empty()) {
+        state_ = ParseState::STATE_WAIT_FIRST_PARAMETER;
+        return ReturnVal::RETURN_ERROR_CONTINUE;
+    }
+
+    uint8_t value = 0;
+    auto    ret   = stringToParameter(num, value);
+    if (ret != ReturnVal::RETURN_SUCCESS_CONTINUE) {
+        return ret;
+    }
+
+    // update state
+    if (ColorVersion::BIT_8 == ColorVersion(value)) {
+        state_ = ParseState::STATE_WAIT_BIT_8_ARGS;
+    }
+    else if (ColorVersion::BIT_24 == ColorVersion(value)) {
+        state_ = ParseState::STATE_WAIT_BIT_24_ARGS_R;
+    }
+    else {
+        // invalid value will reset parse state, and use last parse result
+        state_ = ParseState::STATE_WAIT_FIRST_PARAMETER;
+        return ReturnVal::RETURN_ERROR_CONTINUE;
+    }
+
+    return ReturnVal::RETURN_SUCCESS_CONTINUE;
+}
+
+constexpr SGRParseCore::ReturnVal SGRParseCore::setBit8Color(const std::string_view& num)
+{
+    // 8-bit color parameter empty, will use last color, then parse continue
+    if (num.empty()) {
+        state_ = ParseState::STATE_WAIT_FIRST_PARAMETER;
+        return ReturnVal::RETURN_ERROR_CONTINUE;
+    }
+
+    uint8_t value = 0;
+    auto    ret   = stringToParameter(num, value);
+    if (ret != ReturnVal::RETURN_SUCCESS_CONTINUE) {
+        return ret;
+    }
+
+    // 8-bit color is a palette index, so the result position(front or back) is not changed
+    color_ = ColorTable::bit8Color(value);
+    state_ = ParseState::STATE_WAIT_FIRST_PARAMETER;
+
+    return ReturnVal::RETURN_SUCCESS_BREAK;
+}
+
+constexpr SGRParseCore::ReturnVal SGRParseCore::setBit24Color(const std::string_view& num)
+{
+    if (num.empty()) {
+        // if bit24 color parameter empty, all the 24bit color parameters are invalid.
+        bit24Valid_ = false;
+    }
+
+    // bit24Valid is false, no need to convert num and set color
+    if (bit24Valid_) {
+        uint8_t value = 0;
+        auto    ret   = stringToParameter(num, value);
+        if (ret != ReturnVal::RETURN_SUCCESS_CONTINUE) {
+            return ret;
+        }
+        setBit24ColorValue(value);
+
+        // if state is STATE_WAIT_FIRST_PARAMETER, exist color, so break
+        return (state_ == ParseState::STATE_WAIT_FIRST_PARAMETER ? ReturnVal::RETURN_SUCCESS_BREAK
+                                                                 : ReturnVal::RETURN_SUCCESS_CONTINUE);
+    }
+    else {
+        setBit24ColorValue(0);
+        // restore state after ignoring invalid parameters
+        if (state_ == ParseState::STATE_WAIT_FIRST_PARAMETER) {
+            bit24Valid_ = true;
+        }
+        return ReturnVal::RETURN_ERROR_CONTINUE;
+    }
+}
+
+// save color value and change state
+constexpr void SGRParseCore::setBit24ColorValue(uint8_t num)
+{
+    switch (state_) {
+    case ParseState::STATE_WAIT_BIT_24_ARGS_R: {
+        color_.r = num;
+        state_   = ParseState::STATE_WAIT_BIT_24_ARGS_G;
+    } break;
+    case ParseState::STATE_WAIT_BIT_24_ARGS_G: {
+        color_.g = num;
+        state_   = ParseState::STATE_WAIT_BIT_24_ARGS_B;
+    } break;
+    case ParseState::STATE_WAIT_BIT_24_ARGS_B: {
+        color_.b = num;
+        state_   = ParseState::STATE_WAIT_FIRST_PARAMETER;
+    } break;
+    default:
+        // If the code is not written correctly, it will go here
+        assert(false);
+    }
+}
+
+constexpr SGRParseCore::ReturnVal SGRParseCore::parseParameter(std::string_view num)
+{
+    switch (state_) {
+    case ParseState::STATE_WAIT_FIRST_PARAMETER:
+        return setFirstParameter(num);
+    case ParseState::STATE_WAIT_VERSION:
+        return setColorVersion(num);
+    case ParseState::STATE_WAIT_BIT_8_ARGS:
+        return setBit8Color(num);
+    case ParseState::STATE_WAIT_BIT_24_ARGS_R:
+    case ParseState::STATE_WAIT_BIT_24_ARGS_G:
+    case ParseState::STATE_WAIT_BIT_24_ARGS_B:
+        return setBit24Color(num);
+    }
+    // If the code is not written correctly, it will go here
+    assert(false);
+    return ReturnVal::RETURN_ERROR_BREAK;
+}
+
+constexpr SGRParseCore::ReturnVal SGRParseCore::parse(std::string_view& seqs)
+{
+    auto      pos      = seqs.find_first_of(";:m");
+    ReturnVal parseRet = ReturnVal::RETURN_ERROR_CONTINUE;
+
+    while (pos != std::string_view::npos) {
+        parseRet = parseParameter({ seqs.data(), pos });
+
+        seqs.remove_prefix(pos + 1);
+        pos = seqs.find_first_of(";:m");
+
+        // if return BREAK, return current parse result
+        if (ReturnVal::RETURN_SUCCESS_BREAK == parseRet || ReturnVal::RETURN_ERROR_BREAK == parseRet) {
+            break;
+        }
+    }
+
+    return parseRet;
+}
+
+// reference: https://en.wikipedia.org/wiki/ANSI_escape_code#3-bit_and_4-bit
+// {index, {result, color, state}}
+// If it is a valid color, state must be STATE_WAIT_FIRST_PARAMETER
+constexpr ColorTable::ColorTableArray ColorTable::makeColorTable()
+{
+    ColorTableArray table {};
+    for (auto& core : table) {
+        core = { SGRParseCore::ParseResult::RESULT_UNSUPPORTED_ATTR, {} };
+    }
+
+    // reset to default
+    table[ColorIndex::RESET_DEFAULT] = { SGRParseCore::ParseResult::RESULT_DEFAULT_TEXT_ATTR, {} };
+
+    // 3/4-bit front color
+    table[ColorIndex::F_BLACK]   = { SGRParseCore::ParseResult::RESULT_FRONT_COLOR, { 1, 1, 1 } };
+    table[ColorIndex::F_RED]     = { SGRParseCore::ParseResult::RESULT_FRONT_COLOR, { 222, 56, 43 } };
+    table[ColorIndex::F_GREEN]   = { SGRParseCore::ParseResult::RESULT_FRONT_COLOR, { 57, 181, 74 } };
+    table[ColorIndex::F_YELLOW]  = { SGRParseCore::ParseResult::RESULT_FRONT_COLOR, { 255, 199, 6 } };
+    table[ColorIndex::F_BLUE]    = { SGRParseCore::ParseResult::RESULT_FRONT_COLOR, { 0, 111, 184 } };
+    table[ColorIndex::F_MAGENTA] = { SGRParseCore::ParseResult::RESULT_FRONT_COLOR, { 118, 38, 113 } };
+    table[ColorIndex::F_CYAN]    = { SGRParseCore::ParseResult::RESULT_FRONT_COLOR, { 44, 181, 233 } };
+    table[ColorIndex::F_WHITE]   = { SGRParseCore::ParseResult::RESULT_FRONT_COLOR, { 204, 204, 204 } };
+
+    // custom front color
+    table[ColorIndex::F_CUSTOM_COLOR]
+        = { SGRParseCore::ParseResult::RESULT_FRONT_COLOR, {}, SGRParseCore::ParseState::STATE_WAIT_VERSION };
+
+    // default front color
+    table[ColorIndex::F_DEFAULT_COLOR] = { SGRParseCore::ParseResult::RESULT_DEFAULT_FRONT_COLOR, {} };
+
+    // 3/4-bit back color
+    table[ColorIndex::B_BLACK]   = { SGRParseCore::ParseResult::RESULT_BACK_COLOR, { 1, 1, 1 } };
+    table[ColorIndex::B_RED]     = { SGRParseCore::ParseResult::RESULT_BACK_COLOR, { 222, 56, 43 } };
+    table[ColorIndex::B_GREEN]   = { SGRParseCore::ParseResult::RESULT_BACK_COLOR, { 57, 181, 74 } };
+    table[ColorIndex::B_YELLOW]  = { SGRParseCore::ParseResult::RESULT_BACK_COLOR, { 255, 199, 6 } };
+    table[ColorIndex::B_BLUE]    = { SGRParseCore::ParseResult::RESULT_BACK_COLOR, { 0, 111, 184 } };
+    table[ColorIndex::B_MAGENTA] = { SGRParseCore::ParseResult::RESULT_BACK_COLOR, { 118, 38, 113 } };
+    table[ColorIndex::B_CYAN]    = { SGRParseCore::ParseResult::RESULT_BACK_COLOR, { 44, 181, 233 } };
+    table[ColorIndex::B_WHITE]   = { SGRParseCore::ParseResult::RESULT_BACK_COLOR, { 204, 204, 204 } };
+
+    // custom back color
+    table[ColorIndex::B_CUSTOM_COLOR]
+        = { SGRParseCore::ParseResult::RESULT_BACK_COLOR, {}, SGRParseCore::ParseState::STATE_WAIT_VERSION };
+
+    // default back color
+    table[ColorIndex::B_DEFAULT_COLOR] = { SGRParseCore::ParseResult::RESULT_DEFAULT_BACK_COLOR, {} };
+
+    // 3/4-bit front bright color
+    table[ColorIndex::F_BRIGHT_BLACK]   = { SGRParseCore::ParseResult::RESULT_FRONT_COLOR, { 128, 128, 128 } };
+    table[ColorIndex::F_BRIGHT_RED]     = { SGRParseCore::ParseResult::RESULT_FRONT_COLOR, { 255, 0, 0 } };
+    table[ColorIndex::F_BRIGHT_GREEN]   = { SGRParseCore::ParseResult::RESULT_FRONT_COLOR, { 0, 255, 0 } };
+    table[ColorIndex::F_BRIGHT_YELLOW]  = { SGRParseCore::ParseResult::RESULT_FRONT_COLOR, { 255, 255, 0 } };
+    table[ColorIndex::F_BRIGHT_BLUE]    = { SGRParseCore::ParseResult::RESULT_FRONT_COLOR, { 0, 0, 255 } };
+    table[ColorIndex::F_BRIGHT_MAGENTA] = { SGRParseCore::ParseResult::RESULT_FRONT_COLOR, { 255, 0, 255 } };
+    table[ColorIndex::F_BRIGHT_CYAN]    = { SGRParseCore::ParseResult::RESULT_FRONT_COLOR, { 0, 255, 255 } };
+    table[ColorIndex::F_BRIGHT_WHITE]   = { SGRParseCore::ParseResult::RESULT_FRONT_COLOR, { 255, 255, 255 } };
+
+    // 3/4-bit back bright color
+    table[ColorIndex::B_BRIGHT_BLACK]   = { SGRParseCore::ParseResult::RESULT_BACK_COLOR, { 128, 128, 128 } };
+    table[ColorIndex::B_BRIGHT_RED]     = { SGRParseCore::ParseResult::RESULT_BACK_COLOR, { 255, 0, 0 } };
+    table[ColorIndex::B_BRIGHT_GREEN]   = { SGRParseCore::ParseResult::RESULT_BACK_COLOR, { 0, 255, 0 } };
+    table[ColorIndex::B_BRIGHT_YELLOW]  = { SGRParseCore::ParseResult::RESULT_BACK_COLOR, { 255, 255, 0 } };
+    table[ColorIndex::B_BRIGHT_BLUE]    = { SGRParseCore::ParseResult::RESULT_BACK_COLOR, { 0, 0, 255 } };
+    table[ColorIndex::B_BRIGHT_MAGENTA] = { SGRParseCore::ParseResult::RESULT_BACK_COLOR, { 255, 0, 255 } };
+    table[ColorIndex::B_BRIGHT_CYAN]    = { SGRParseCore::ParseResult::RESULT_BACK_COLOR, { 0, 255, 255 } };
+    table[ColorIndex::B_BRIGHT_WHITE]   = { SGRParseCore::ParseResult::RESULT_BACK_COLOR, { 255, 255, 255 } };
+
+    return table;
+}
+
+// reference: https://en.wikipedia.org/wiki/ANSI_escape_code#8-bit
+constexpr ColorTable::PaletteArray ColorTable::makePalette(const ColorTableArray& colorTable)
+{
+    PaletteArray palette {};
+
+    // Standard colors and High-intensity colors
+    for (uint8_t i = 0; i < 8; ++i) {
+        palette[i]     = colorTable[ColorIndex::F_BLACK + i].color_;
+        palette[i + 8] = colorTable[ColorIndex::F_BRIGHT_BLACK + i].color_;
+    }
+
+    // 216 colors
+    constexpr uint8_t colorValue[] { 0, 95, 135, 175, 215, 255 };
+    for (int i = 16; i < 232; ++i) {
+        auto val       = i - 16;
+        auto remainder = val % 36;
+        palette[i]     = { colorValue[val / 36], colorValue[remainder / 6], colorValue[remainder % 6] };
+    }
+
+    // Grayscale colors
+    for (int i = 232; i < 256; ++i) {
+        auto colorValue = uint8_t((i - 232) * 10 + 8);
+        palette[i]      = { colorValue, colorValue, colorValue };
+    }
+
+    return palette;
+}
+
+inline constexpr ColorTable::ColorTableArray ColorTable::colorTable = makeColorTable();
+inline constexpr ColorTable::PaletteArray    ColorTable::palette    = makePalette(colorTable);
+
+constexpr SGRParseCore ColorTable::index(ColorIndex num)
+{
+    return colorTable[num];
+}
+
+constexpr RGB ColorTable::bit8Color(uint8_t num)
+{
+    return palette[num];
+}
+
+/*
+ * @param defaultTextAttr   attribute of reset parameters
+ * @param parameters        SGR parameter bytes without "\033[" and "m", example: "1;31"
+ * @return                  {return value, effect of the parameters}
+ *
+ * If the return value is ERROR, the transform keeps all fields.
+ */
+constexpr std::pair<Return, TextAttributeTransform> parseSGRTransform(const TextAttribute& defaultTextAttr,
+                                                                      std::string_view     parameters)
+{
+    using Field = TextAttributeTransform::Field;
+
+    using ParseResult = SGRParseCore::ParseResult;
+    using ReturnVal   = SGRParseCore::ReturnVal;
+
+    SGRParseCore           core {};
+    ReturnVal              ctxRet = ReturnVal::RETURN_SUCCESS_BREAK;
+    TextAttributeTransform transform { 0, defaultTextAttr };
+
+    // the final byte terminates the last parameter, so there is one more parameter than separators
+    size_t begin = 0;
+    bool   last  = false;
+    while (!last) {
+        auto pos = parameters.find_first_of(";:", begin);
+        last     = (pos == std::string_view::npos);
+
+        // continuous parsing, log the result when a parameter group is finished
+        ctxRet = core.parseParameter(parameters.substr(begin, last ? std::string_view::npos : pos - begin));
+        begin  = pos + 1;
+        if (!last && ctxRet != ReturnVal::RETURN_SUCCESS_BREAK && ctxRet != ReturnVal::RETURN_ERROR_BREAK) {
+            continue;
+        }
+
+        switch (core.result()) {
+        case ParseResult::RESULT_FRONT_COLOR: {
+            transform.mask |= Field::FIELD_STATE | Field::FIELD_FRONT;
+            transform.value.state       = TextAttribute::State::CUSTOM;
+            transform.value.color.front = core.color();
+        } break;
+        case ParseResult::RESULT_BACK_COLOR: {
+            transform.mask |= Field::FIELD_STATE | Field::FIELD_BACK;
+            transform.value.state      = TextAttribute::State::CUSTOM;
+            transform.value.color.back = core.color();
+        } break;
+        case ParseResult::RESULT_DEFAULT_FRONT_COLOR: {
+            transform.mask |= Field::FIELD_FRONT;
+            transform.value.color.front = defaultTextAttr.color.front;
+        } break;
+        case ParseResult::RESULT_DEFAULT_BACK_COLOR: {
+            transform.mask |= Field::FIELD_BACK;
+            transform.value.color.back = defaultTextAttr.color.back;
+        } break;
+        case ParseResult::RESULT_DEFAULT_TEXT_ATTR: {
+            transform = { Field::FIELD_STATE | Field::FIELD_FRONT | Field::FIELD_BACK, defaultTextAttr };
+        } break;
+        case ParseResult::RESULT_CURRENT_TEXT_ATTR:
+        case ParseResult::RESULT_UNSUPPORTED_ATTR: {
+            // keep parsed attribute, do nothing
+        } break;
+        }
+
+        core.reset();
+
+        // RETURN_ERROR_BREAK aborts parsing and invalidates parsed results
+        if (ctxRet == ReturnVal::RETURN_ERROR_BREAK) {
+            return { Return::PARSE_ERROR, { 0, defaultTextAttr } };
+        }
+    }
+
+    return { Return::PARSE_SUCC, transform };
+}
+
+// not constexpr, so reaching it while evaluating a constant expression fails the build
+inline void invalidSGRLiteral() {}
+
+/*
+ * Parse a literal SGR sequence at compile time, example:
+ *     constexpr auto attr = sgrLiteral(defaultAttr, defaultAttr, "\033[1;38;2;95;135;175m");
+ *
+ * @param defaultTextAttr   attribute of reset parameters
+ * @param currentTextAttr   attribute before the sequence
+ * @param sequence          SGR sequence, an invalid sequence fails the build in a constant expression
+ * @return                  attribute after the sequence
+ */
+constexpr TextAttribute sgrLiteral(const TextAttribute& defaultTextAttr, const TextAttribute& currentTextAttr,
+                                   std::string_view sequence)
+{
+    if (sequence.size() < SequenceStartCnt::HEAD_CNT + 1 || sequence[0] != SequenceFirst::EXC
+        || sequence[1] != SequenceSecond::CSI || sequence.back() != CSIFinalBytes::SGR) {
+        invalidSGRLiteral();
+    }
+
+    const TextAttribute defaultAttr { TextAttribute::State::DEFAULT, defaultTextAttr.color };
+    auto                parameters = sequence.substr(HEAD_CNT, sequence.size() - HEAD_CNT - 1);
+    auto                ret        = parseSGRTransform(defaultAttr, parameters);
+    if (ret.first != Return::PARSE_SUCC) {
+        invalidSGRLiteral();
+    }
+    return ret.second.apply(currentTextAttr);
+}
+
+} // namespace ANSI
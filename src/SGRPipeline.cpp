@@ -0,0 +1,184 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include "SGRPipeline.h"
+
+#include <algorithm>
+#include <cassert>
+#include <thread>
+
+#include "SGRStreamParser.h"
+#include "SPSCQueue.h"
+
+namespace ANSI {
+
+using Clock = std::chrono::steady_clock;
+
+struct ByteBlock {
+    std::vector<char> data;
+    size_t            len;
+    Clock::time_point readTime;
+};
+
+// tries before blocking, a short wait is cheaper spinning than sleeping
+static constexpr int WAIT_SPIN_CNT = 64;
+
+// wait until tryFunc succeeds, spin a little before blocking in waitFunc
+template <typename TryFunc, typename WaitFunc>
+static void waitFor(TryFunc&& tryFunc, WaitFunc&& waitFunc, size_t& waits, std::chrono::nanoseconds& blocked)
+{
+    if (tryFunc()) {
+        return;
+    }
+
+    ++waits;
+    for (int spin = 0; spin < WAIT_SPIN_CNT; ++spin) {
+        if (tryFunc()) {
+            return;
+        }
+    }
+
+    auto begin = Clock::now();
+    do {
+        waitFunc();
+    } while (!tryFunc());
+    blocked += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin);
+}
+
+static void recordPush(SGRPipeline::QueueMetrics& metrics, size_t depth)
+{
+    ++metrics.pushes;
+    metrics.depthSum += depth;
+    metrics.maxDepth = std::max(metrics.maxDepth, depth);
+}
+
+SGRPipeline::SGRPipeline(const TextAttribute& defaultTextAttr, const TextAttribute& currentTextAttr,
+                         const Config& config)
+    : defaultTextAttr_(defaultTextAttr)
+    , currentTextAttr_(currentTextAttr)
+    , config_(config)
+{
+    config_.blockSize  = std::max<size_t>(config_.blockSize, 1);
+    config_.queueDepth = std::max<size_t>(config_.queueDepth, 1);
+}
+
+SGRPipeline::Metrics SGRPipeline::run(const Reader& reader, const Consumer& consumer)
+{
+    // queueDepth items circulate between two stages, one more slot for the end of stream, which is nullptr
+    const size_t           depth = config_.queueDepth;
+    std::vector<ByteBlock> blocks(depth);
+    std::vector<RunBatch>  batches(depth);
+    SPSCQueue<ByteBlock*>  blockQueue(depth + 1);
+    SPSCQueue<ByteBlock*>  freeBlocks(depth + 1);
+    SPSCQueue<RunBatch*>   batchQueue(depth + 1);
+    SPSCQueue<RunBatch*>   freeBatches(depth + 1);
+    for (auto& block : blocks) {
+        block.data.resize(config_.blockSize);
+        freeBlocks.tryPush(&block);
+    }
+    for (auto& batch : batches) {
+        freeBatches.tryPush(&batch);
+    }
+
+    // every stage writes its own fields of metrics
+    Metrics       metrics;
+    TextAttribute endAttr = currentTextAttr_;
+    auto          begin   = Clock::now();
+
+    std::thread readerThread([&] {
+        for (;;) {
+            ByteBlock* block = nullptr;
+            waitFor([&] { return freeBlocks.tryPop(block); }, [&] { freeBlocks.waitNotEmpty(); },
+                    metrics.blockQueue.stalls, metrics.blockQueue.stallTime);
+            block->len      = reader(block->data.data(), block->data.size());
+            block->readTime = Clock::now();
+            metrics.bytes += block->len;
+
+            ByteBlock* item = block->len == 0 ? nullptr : block;
+            waitFor([&] { return blockQueue.tryPush(item); }, [&] { blockQueue.waitNotFull(); },
+                    metrics.blockQueue.stalls, metrics.blockQueue.stallTime);
+            recordPush(metrics.blockQueue, blockQueue.size());
+            if (item == nullptr) {
+                break;
+            }
+        }
+    });
+
+    std::thread parserThread([&] {
+        SGRStreamParser parser(defaultTextAttr_, currentTextAttr_);
+        for (uint64_t sequence = 0;; ++sequence) {
+            ByteBlock* block = nullptr;
+            RunBatch*  batch = nullptr;
+            waitFor([&] { return blockQueue.tryPop(block); }, [&] { blockQueue.waitNotEmpty(); },
+                    metrics.blockQueue.starves, metrics.blockQueue.starveTime);
+            waitFor([&] { return freeBatches.tryPop(batch); }, [&] { freeBatches.waitNotEmpty(); },
+                    metrics.batchQueue.stalls, metrics.batchQueue.stallTime);
+
+            batch->text.clear();
+            batch->runs.clear();
+            batch->sequence = sequence;
+            auto onText     = [batch](std::string_view text, const TextAttribute& attr) {
+                auto& runs = batch->runs;
+                if (!runs.empty() && runs.back().attr == attr) {
+                    runs.back().len += text.size();
+                }
+                else {
+                    runs.push_back({ batch->text.size(), text.size(), attr });
+                }
+                batch->text.append(text.data(), text.size());
+            };
+
+            if (block != nullptr) {
+                batch->readTime = block->readTime;
+                parser.parse({ block->data.data(), block->len }, onText);
+                bool freed = freeBlocks.tryPush(block);
+                assert(freed);
+                (void)freed;
+            }
+            else {
+                // end of stream, an unfinished sequence is text
+                batch->readTime = Clock::now();
+                parser.finish(onText);
+            }
+
+            waitFor([&] { return batchQueue.tryPush(batch); }, [&] { batchQueue.waitNotFull(); },
+                    metrics.batchQueue.stalls, metrics.batchQueue.stallTime);
+            recordPush(metrics.batchQueue, batchQueue.size());
+            if (block == nullptr) {
+                waitFor([&] { return batchQueue.tryPush(nullptr); }, [&] { batchQueue.waitNotFull(); },
+                        metrics.batchQueue.stalls, metrics.batchQueue.stallTime);
+                break;
+            }
+        }
+        endAttr = parser.currentTextAttr();
+    });
+
+    for (;;) {
+        RunBatch* batch = nullptr;
+        waitFor([&] { return batchQueue.tryPop(batch); }, [&] { batchQueue.waitNotEmpty(); },
+                metrics.batchQueue.starves, metrics.batchQueue.starveTime);
+        if (batch == nullptr) {
+            break;
+        }
+
+        auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - batch->readTime);
+        metrics.latencySum += latency;
+        metrics.latencyMax = std::max(metrics.latencyMax, latency);
+
+        consumer(*batch);
+        ++metrics.batches;
+        bool freed = freeBatches.tryPush(batch);
+        assert(freed);
+        (void)freed;
+    }
+
+    readerThread.join();
+    parserThread.join();
+
+    currentTextAttr_ = endAttr;
+    metrics.seconds  = std::chrono::duration<double>(Clock::now() - begin).count();
+    return metrics;
+}
+
+} // namespace ANSI
@@ -0,0 +1,104 @@
+//
+// Created by marvin on 26-10-17.
+//
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "SGRParser.h"
+
+namespace ANSI {
+
+/*
+ * Three stage pipeline for live streams: a reader thread fills byte blocks, a parser thread runs
+ * SGRStreamParser on them, and the calling thread consumes run batches.
+ *
+ * Stages are connected by bounded SPSCQueue, blocks and batches are recycled through queues in the
+ * other direction, so a slow stage stops the stages before it once queueDepth items are in flight,
+ * and nothing is allocated after the first batches reached their size.
+ */
+class SGRPipeline {
+public:
+    struct Config {
+        size_t blockSize  = 64 << 10; // bytes read at once
+        size_t queueDepth = 8;        // blocks or batches in flight between two stages
+    };
+
+    struct Run {
+        size_t        start; // relative to text of the batch
+        size_t        len;
+        TextAttribute attr;
+    };
+
+    // text and runs of one block, a sequence split between two blocks belongs to the second one
+    struct RunBatch {
+        std::string                           text;
+        std::vector<Run>                      runs;
+        uint64_t                              sequence; // block number, starting from 0
+        std::chrono::steady_clock::time_point readTime; // end of reading the block
+    };
+
+    struct QueueMetrics {
+        size_t pushes   = 0;
+        size_t depthSum = 0; // queue size after every push, depthSum / pushes is the average depth
+        size_t maxDepth = 0;
+        size_t stalls   = 0; // waits of the producer because the queue is full or no item is free
+        size_t starves  = 0; // waits of the consumer because the queue is empty
+
+        // time blocked after spinning, a stage waiting for the reader sleeps instead of using a core
+        std::chrono::nanoseconds stallTime { 0 };
+        std::chrono::nanoseconds starveTime { 0 };
+    };
+
+    struct Metrics {
+        size_t       bytes   = 0;
+        size_t       batches = 0;
+        double       seconds = 0;
+        QueueMetrics blockQueue; // reader to parser
+        QueueMetrics batchQueue; // parser to consumer
+
+        // time from the end of reading a block to the consumer receiving its batch
+        std::chrono::nanoseconds latencySum { 0 };
+        std::chrono::nanoseconds latencyMax { 0 };
+    };
+
+    /*
+     * @param buf       buffer to fill
+     * @param size      buffer size
+     * @return          bytes read, 0 is the end of the stream
+     */
+    using Reader = std::function<size_t(char* buf, size_t size)>;
+
+    // a batch is only valid during the call
+    using Consumer = std::function<void(const RunBatch& batch)>;
+
+public:
+    SGRPipeline(const TextAttribute& defaultTextAttr, const TextAttribute& currentTextAttr, const Config& config);
+    ~SGRPipeline() = default;
+
+    SGRPipeline(const SGRPipeline&)            = delete;
+    SGRPipeline(SGRPipeline&&)                 = delete;
+    SGRPipeline& operator=(const SGRPipeline&) = delete;
+    SGRPipeline& operator=(SGRPipeline&&)      = delete;
+
+    /*
+     * Run until reader returns 0 and all batches are consumed, consumer runs on the calling thread.
+     *
+     * @return          metrics of this run
+     */
+    Metrics run(const Reader& reader, const Consumer& consumer);
+
+    // attribute at the end of the last run
+    inline const TextAttribute& currentTextAttr() const { return currentTextAttr_; }
+
+private:
+    TextAttribute defaultTextAttr_;
+    TextAttribute currentTextAttr_;
+    Config        config_;
+};
+
+} // namespace ANSI
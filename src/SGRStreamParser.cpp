@@ -0,0 +1,142 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include "SGRStreamParser.h"
+
+#include "CSIScanner.h"
+#include "SIMD.h"
+
+namespace ANSI {
+
+SGRStreamParser::SGRStreamParser(const TextAttribute& defaultTextAttr, const TextAttribute& currentTextAttr)
+    : state_(StreamState::STATE_TEXT)
+    , currentTextAttr_(currentTextAttr)
+    , sgrParser_(defaultTextAttr)
+{
+    pending_.reserve(MAX_SEQUENCE_LEN);
+}
+
+bool SGRStreamParser::next(std::string_view& chunk, std::string_view& text)
+{
+    // bytes before the ESC were reported in the last call
+    if (state_ == StreamState::STATE_OSC_CANCELLED) {
+        pending_.assign(1, static_cast<char>(SequenceFirst::EXC));
+        state_ = StreamState::STATE_ESCAPE;
+    }
+
+    while (!chunk.empty()) {
+        if (state_ == StreamState::STATE_TEXT) {
+            const char* begin = chunk.data();
+            const char* esc   = SIMD::findEscape(begin, begin + chunk.size());
+            // text before ESC is complete, report it at once
+            if (esc != begin) {
+                text = { begin, size_t(esc - begin) };
+                chunk.remove_prefix(text.size());
+                return true;
+            }
+
+            // whole sequence in this chunk, no need to copy it
+            auto len = CSIScanner::matchControl(chunk);
+            if (len != 0) {
+                applySequence(chunk.substr(0, len));
+                chunk.remove_prefix(len);
+                continue;
+            }
+
+            // sequence is split or invalid, collect it byte by byte
+            pending_.assign(1, static_cast<char>(SequenceFirst::EXC));
+            state_ = StreamState::STATE_ESCAPE;
+            chunk.remove_prefix(1);
+            continue;
+        }
+
+        auto ch       = static_cast<uint8_t>(chunk.front());
+        bool isOSC    = state_ == StreamState::STATE_OSC || state_ == StreamState::STATE_OSC_ESCAPE;
+        bool isFinal  = false;
+        bool isValid  = pending_.size() < (isOSC ? MAX_OSC_LEN : MAX_SEQUENCE_LEN);
+        bool isInterm = ch >= CSIIntermediateBytes::CSIIntermediateBegin
+            && ch <= CSIIntermediateBytes::CSIIntermediateEnd;
+
+        switch (state_) {
+        case StreamState::STATE_ESCAPE: {
+            isValid = isValid && (ch == SequenceSecond::CSI || ch == SequenceSecond::OSC);
+            state_  = ch == SequenceSecond::OSC ? StreamState::STATE_OSC : StreamState::STATE_CSI_PARAMETER;
+        } break;
+        case StreamState::STATE_CSI_PARAMETER: {
+            if (isInterm) {
+                state_ = StreamState::STATE_CSI_INTERMEDIATE;
+                break;
+            }
+            if (ch >= CSIParameterBytes::CSI_PARAMETER_BEGIN && ch <= CSIParameterBytes::CSI_PARAMETER_END) {
+                break;
+            }
+            isFinal = true;
+        } break;
+        case StreamState::STATE_CSI_INTERMEDIATE: {
+            isFinal = !isInterm;
+        } break;
+        case StreamState::STATE_OSC: {
+            isValid = isValid && ch != '\n';
+            isFinal = ch == OSCTerminator::BEL;
+            if (ch == SequenceFirst::EXC) {
+                state_ = StreamState::STATE_OSC_ESCAPE;
+            }
+        } break;
+        case StreamState::STATE_OSC_ESCAPE: {
+            // the OSC is cancelled, but its ESC can start the next sequence
+            if (!isValid || ch != SequenceSecond::ST) {
+                state_ = StreamState::STATE_OSC_CANCELLED;
+                text   = std::string_view { pending_ }.substr(0, pending_.size() - 1);
+                return true;
+            }
+            isFinal = true;
+        } break;
+        case StreamState::STATE_TEXT:
+        case StreamState::STATE_OSC_CANCELLED:
+            break;
+        }
+        if (isFinal && !isOSC) {
+            isValid = isValid && ch >= CSIFinalBytes::CSIFinalBegin && ch <= CSIFinalBytes::CSIFinalEnd;
+        }
+
+        // not a control sequence, report collected bytes as text, current byte is parsed again as text
+        if (!isValid) {
+            state_ = StreamState::STATE_TEXT;
+            text   = pending_;
+            return true;
+        }
+
+        pending_.push_back(static_cast<char>(ch));
+        chunk.remove_prefix(1);
+
+        if (isFinal) {
+            state_ = StreamState::STATE_TEXT;
+            applySequence(pending_);
+        }
+    }
+    return false;
+}
+
+bool SGRStreamParser::flush(std::string_view& text)
+{
+    if (state_ == StreamState::STATE_TEXT) {
+        return false;
+    }
+    // only the ESC which ended the cancelled OSC is not reported yet
+    text   = state_ == StreamState::STATE_OSC_CANCELLED ? std::string_view { pending_ }.substr(pending_.size() - 1)
+                                                        : std::string_view { pending_ };
+    state_ = StreamState::STATE_TEXT;
+    return true;
+}
+
+void SGRStreamParser::applySequence(std::string_view sequence)
+{
+    // other control sequences and OSC are removed without effect
+    if (sequence[1] != SequenceSecond::CSI || static_cast<uint8_t>(sequence.back()) != CSIFinalBytes::SGR) {
+        return;
+    }
+    currentTextAttr_ = sgrParser_.parseSGRSequence(currentTextAttr_, sequence).second;
+}
+
+} // namespace ANSI
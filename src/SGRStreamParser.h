@@ -0,0 +1,97 @@
+//
+// Created by marvin on 26-10-17.
+//
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "CSIScanner.h"
+#include "SGRParser.h"
+
+namespace ANSI {
+
+/*
+ * Push-style parser for byte streams split at arbitrary positions.
+ *
+ * Text is reported as soon as it is known, a control sequence split between two chunks is kept until it is
+ * complete, so the memory used does not depend on the stream or line length. CSI sequences and OSC are found
+ * like CSIScanner::visit finds them, so the text is the same however the stream is split.
+ */
+class SGRStreamParser {
+public:
+    // a sequence longer than this is not a control sequence, its bytes are reported as text like CSIScanner does
+    static constexpr size_t MAX_SEQUENCE_LEN = CSIScanner::MAX_SEQUENCE_LEN;
+    static constexpr size_t MAX_OSC_LEN      = CSIScanner::MAX_OSC_LEN;
+
+public:
+    SGRStreamParser(const TextAttribute& defaultTextAttr, const TextAttribute& currentTextAttr);
+    ~SGRStreamParser() = default;
+
+    SGRStreamParser(const SGRStreamParser&)            = delete;
+    SGRStreamParser(SGRStreamParser&&)                 = delete;
+    SGRStreamParser& operator=(const SGRStreamParser&) = delete;
+    SGRStreamParser& operator=(SGRStreamParser&&)      = delete;
+
+    /*
+     * @param chunk     unparsed bytes, consumed bytes are removed
+     * @param text      next text run, valid until the next call
+     * @return          false if chunk is used up and there is no more text
+     *
+     * The attribute of the returned text is currentTextAttr().
+     */
+    bool next(std::string_view& chunk, std::string_view& text);
+
+    /*
+     * End of stream, an unfinished sequence is reported as text.
+     *
+     * @return          false if there is no unfinished sequence
+     */
+    bool flush(std::string_view& text);
+
+    /*
+     * @param chunk     bytes of the stream
+     * @param onText    called with (std::string_view text, const TextAttribute& attr) for every text run
+     */
+    template <typename Callback>
+    void parse(std::string_view chunk, Callback&& onText)
+    {
+        std::string_view text;
+        while (next(chunk, text)) {
+            onText(text, currentTextAttr_);
+        }
+    }
+
+    template <typename Callback>
+    void finish(Callback&& onText)
+    {
+        std::string_view text;
+        if (flush(text)) {
+            onText(text, currentTextAttr_);
+        }
+    }
+
+    inline const TextAttribute& currentTextAttr() const { return currentTextAttr_; }
+
+private:
+    // byte level state, parameters are parsed by SGRParseCore when the sequence is complete
+    enum class StreamState {
+        STATE_TEXT,
+        STATE_ESCAPE,
+        STATE_CSI_PARAMETER,
+        STATE_CSI_INTERMEDIATE,
+        STATE_OSC,
+        STATE_OSC_ESCAPE,    // ESC in an OSC, which must start ST
+        STATE_OSC_CANCELLED, // ESC in an OSC did not start ST, it is the last pending byte and starts a sequence
+    };
+
+    void applySequence(std::string_view sequence);
+
+private:
+    StreamState   state_;
+    std::string   pending_;
+    TextAttribute currentTextAttr_;
+    SGRParser     sgrParser_;
+};
+
+} // namespace ANSI
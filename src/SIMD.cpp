@@ -0,0 +1,264 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include "SIMD.h"
+
+#include <atomic>
+#include <cstring>
+
+#include "ANSI.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define SGR_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace ANSI {
+
+using Level = SIMD::Level;
+
+struct SIMDImpl {
+    Level level;
+    const char* (*findEscape)(const char* begin, const char* end);
+    const char* (*findHTMLSpecial)(const char* begin, const char* end);
+    const char* (*findNonPrintableASCII)(const char* begin, const char* end);
+};
+
+// scalar
+
+static const char* findEscapeScalar(const char* begin, const char* end)
+{
+    auto ret = static_cast<const char*>(std::memchr(begin, SequenceFirst::EXC, end - begin));
+    return ret == nullptr ? end : ret;
+}
+
+// control bytes except tab, line feed and carriage return are not allowed in HTML text
+static inline bool isHTMLSpecial(char ch)
+{
+    auto byte = static_cast<uint8_t>(ch);
+    if (byte < 0x20) {
+        return byte != '\t' && byte != '\n' && byte != '\r';
+    }
+    return ch == '<' || ch == '>' || ch == '&' || ch == '"' || ch == '\'' || byte == 0x7F;
+}
+
+static const char* findHTMLSpecialScalar(const char* begin, const char* end)
+{
+    for (; begin != end; ++begin) {
+        if (isHTMLSpecial(*begin)) {
+            return begin;
+        }
+    }
+    return end;
+}
+
+static const char* findNonPrintableASCIIScalar(const char* begin, const char* end)
+{
+    for (; begin != end; ++begin) {
+        if (static_cast<uint8_t>(*begin - 0x20) > 0x7E - 0x20) {
+            return begin;
+        }
+    }
+    return end;
+}
+
+constexpr SIMDImpl scalarImpl { Level::SCALAR, findEscapeScalar, findHTMLSpecialScalar, findNonPrintableASCIIScalar };
+
+#ifdef SGR_SIMD_X86
+
+// SSE2
+
+__attribute__((target("sse2"))) static const char* findEscapeSSE2(const char* begin, const char* end)
+{
+    const auto esc = _mm_set1_epi8(SequenceFirst::EXC);
+    for (; end - begin >= 16; begin += 16) {
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        auto mask  = _mm_movemask_epi8(_mm_cmpeq_epi8(block, esc));
+        if (mask != 0) {
+            return begin + __builtin_ctz(static_cast<unsigned>(mask));
+        }
+    }
+    return findEscapeScalar(begin, end);
+}
+
+__attribute__((target("sse2"))) static const char* findHTMLSpecialSSE2(const char* begin, const char* end)
+{
+    const auto lt   = _mm_set1_epi8('<');
+    const auto gt   = _mm_set1_epi8('>');
+    const auto amp  = _mm_set1_epi8('&');
+    const auto quot = _mm_set1_epi8('"');
+    const auto apos = _mm_set1_epi8('\'');
+    const auto del  = _mm_set1_epi8(0x7F);
+    const auto c0   = _mm_set1_epi8(0x1F);
+    const auto tab  = _mm_set1_epi8('\t');
+    const auto lf   = _mm_set1_epi8('\n');
+    const auto cr   = _mm_set1_epi8('\r');
+    for (; end - begin >= 16; begin += 16) {
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        auto eq    = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, lt), _mm_cmpeq_epi8(block, gt)),
+                                  _mm_or_si128(_mm_cmpeq_epi8(block, amp), _mm_cmpeq_epi8(block, quot)));
+        eq         = _mm_or_si128(eq, _mm_or_si128(_mm_cmpeq_epi8(block, apos), _mm_cmpeq_epi8(block, del)));
+        // unsigned block <= 0x1F, except the allowed white space
+        auto ctrl  = _mm_cmpeq_epi8(_mm_min_epu8(block, c0), block);
+        auto space = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, tab), _mm_cmpeq_epi8(block, lf)),
+                                  _mm_cmpeq_epi8(block, cr));
+        auto mask  = _mm_movemask_epi8(_mm_or_si128(eq, _mm_andnot_si128(space, ctrl)));
+        if (mask != 0) {
+            return begin + __builtin_ctz(static_cast<unsigned>(mask));
+        }
+    }
+    return findHTMLSpecialScalar(begin, end);
+}
+
+// bytes are signed, so bytes >= 0x80 are not greater than 0x1F
+__attribute__((target("sse2"))) static const char* findNonPrintableASCIISSE2(const char* begin, const char* end)
+{
+    const auto low  = _mm_set1_epi8(0x1F);
+    const auto high = _mm_set1_epi8(0x7F);
+    for (; end - begin >= 16; begin += 16) {
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        auto in    = _mm_and_si128(_mm_cmpgt_epi8(block, low), _mm_cmplt_epi8(block, high));
+        auto mask  = ~_mm_movemask_epi8(in) & 0xFFFF;
+        if (mask != 0) {
+            return begin + __builtin_ctz(static_cast<unsigned>(mask));
+        }
+    }
+    return findNonPrintableASCIIScalar(begin, end);
+}
+
+constexpr SIMDImpl sse2Impl { Level::SSE2, findEscapeSSE2, findHTMLSpecialSSE2, findNonPrintableASCIISSE2 };
+
+// AVX2
+
+__attribute__((target("avx2"))) static const char* findEscapeAVX2(const char* begin, const char* end)
+{
+    const auto esc = _mm256_set1_epi8(SequenceFirst::EXC);
+    for (; end - begin >= 32; begin += 32) {
+        auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+        auto mask  = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, esc));
+        if (mask != 0) {
+            return begin + __builtin_ctz(static_cast<unsigned>(mask));
+        }
+    }
+    return findEscapeSSE2(begin, end);
+}
+
+__attribute__((target("avx2"))) static const char* findHTMLSpecialAVX2(const char* begin, const char* end)
+{
+    const auto lt   = _mm256_set1_epi8('<');
+    const auto gt   = _mm256_set1_epi8('>');
+    const auto amp  = _mm256_set1_epi8('&');
+    const auto quot = _mm256_set1_epi8('"');
+    const auto apos = _mm256_set1_epi8('\'');
+    const auto del  = _mm256_set1_epi8(0x7F);
+    const auto c0   = _mm256_set1_epi8(0x1F);
+    const auto tab  = _mm256_set1_epi8('\t');
+    const auto lf   = _mm256_set1_epi8('\n');
+    const auto cr   = _mm256_set1_epi8('\r');
+    for (; end - begin >= 32; begin += 32) {
+        auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+        auto eq    = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, lt), _mm256_cmpeq_epi8(block, gt)),
+                                     _mm256_or_si256(_mm256_cmpeq_epi8(block, amp), _mm256_cmpeq_epi8(block, quot)));
+        eq = _mm256_or_si256(eq, _mm256_or_si256(_mm256_cmpeq_epi8(block, apos), _mm256_cmpeq_epi8(block, del)));
+        // unsigned block <= 0x1F, except the allowed white space
+        auto ctrl  = _mm256_cmpeq_epi8(_mm256_min_epu8(block, c0), block);
+        auto space = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, tab), _mm256_cmpeq_epi8(block, lf)),
+                                     _mm256_cmpeq_epi8(block, cr));
+        auto mask  = _mm256_movemask_epi8(_mm256_or_si256(eq, _mm256_andnot_si256(space, ctrl)));
+        if (mask != 0) {
+            return begin + __builtin_ctz(static_cast<unsigned>(mask));
+        }
+    }
+    return findHTMLSpecialSSE2(begin, end);
+}
+
+__attribute__((target("avx2"))) static const char* findNonPrintableASCIIAVX2(const char* begin, const char* end)
+{
+    const auto low  = _mm256_set1_epi8(0x1F);
+    const auto high = _mm256_set1_epi8(0x7F);
+    for (; end - begin >= 32; begin += 32) {
+        auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+        auto in    = _mm256_and_si256(_mm256_cmpgt_epi8(block, low), _mm256_cmpgt_epi8(high, block));
+        auto mask  = ~static_cast<unsigned>(_mm256_movemask_epi8(in));
+        if (mask != 0) {
+            return begin + __builtin_ctz(mask);
+        }
+    }
+    return findNonPrintableASCIISSE2(begin, end);
+}
+
+constexpr SIMDImpl avx2Impl { Level::AVX2, findEscapeAVX2, findHTMLSpecialAVX2, findNonPrintableASCIIAVX2 };
+
+#endif
+
+static const SIMDImpl* implOf(Level level)
+{
+#ifdef SGR_SIMD_X86
+    switch (level) {
+    case Level::AVX2:
+        return &avx2Impl;
+    case Level::SSE2:
+        return &sse2Impl;
+    case Level::SCALAR:
+        break;
+    }
+#endif
+    (void)level;
+    return &scalarImpl;
+}
+
+static std::atomic<const SIMDImpl*>& currentImpl()
+{
+    static std::atomic<const SIMDImpl*> impl { implOf(SIMD::supportedLevel()) };
+    return impl;
+}
+
+Level SIMD::supportedLevel()
+{
+#ifdef SGR_SIMD_X86
+    static const Level supported = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return Level::AVX2;
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            return Level::SSE2;
+        }
+        return Level::SCALAR;
+    }();
+    return supported;
+#else
+    return Level::SCALAR;
+#endif
+}
+
+Level SIMD::level()
+{
+    return currentImpl().load(std::memory_order_relaxed)->level;
+}
+
+void SIMD::setLevel(Level level)
+{
+    if (static_cast<int>(level) > static_cast<int>(supportedLevel())) {
+        level = supportedLevel();
+    }
+    currentImpl().store(implOf(level), std::memory_order_relaxed);
+}
+
+const char* SIMD::findEscape(const char* begin, const char* end)
+{
+    return currentImpl().load(std::memory_order_relaxed)->findEscape(begin, end);
+}
+
+const char* SIMD::findHTMLSpecial(const char* begin, const char* end)
+{
+    return currentImpl().load(std::memory_order_relaxed)->findHTMLSpecial(begin, end);
+}
+
+const char* SIMD::findNonPrintableASCII(const char* begin, const char* end)
+{
+    return currentImpl().load(std::memory_order_relaxed)->findNonPrintableASCII(begin, end);
+}
+
+} // namespace ANSI
@@ -0,0 +1,54 @@
+//
+// Created by marvin on 26-10-17.
+//
+#pragma once
+
+#include <cstddef>
+
+namespace ANSI {
+
+class SIMD {
+public:
+    enum class Level {
+        SCALAR,
+        SSE2,
+        AVX2,
+    };
+
+public:
+    SIMD()  = delete;
+    ~SIMD() = delete;
+
+    // the best level supported by the running CPU
+    static Level supportedLevel();
+
+    // the level currently used by the find functions
+    static Level level();
+
+    // force a level, a level not supported by the CPU is clamped to supportedLevel()
+    static void setLevel(Level level);
+
+    /*
+     * @param begin     search begin
+     * @param end       search end
+     * @return          first ESC(SequenceFirst::EXC) byte in [begin, end), end if not found
+     */
+    static const char* findEscape(const char* begin, const char* end);
+
+    /*
+     * @param begin     search begin
+     * @param end       search end
+     * @return          first byte in [begin, end) which must be escaped or removed in HTML: < > & " ', DEL and
+     *                  control bytes other than \t \n \r, end if not found
+     */
+    static const char* findHTMLSpecial(const char* begin, const char* end);
+
+    /*
+     * @param begin     search begin
+     * @param end       search end
+     * @return          first byte in [begin, end) which is not printable ASCII (0x20 - 0x7E), end if not found
+     */
+    static const char* findNonPrintableASCII(const char* begin, const char* end);
+};
+
+} // namespace ANSI
@@ -0,0 +1,138 @@
+//
+// Created by marvin on 26-10-17.
+//
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace ANSI {
+
+/*
+ * Bounded lock-free queue for one producer thread and one consumer thread.
+ *
+ * Head and tail are on their own cache lines, and every side keeps a copy of the other side's index,
+ * so the shared indexes are only read again when the queue looks full or empty.
+ *
+ * A side can block until the queue is not full or not empty. tryPush and tryPop only take the mutex
+ * when the other side is blocked, the fence before reading the waiter count pairs with the one in wait().
+ */
+template <typename T>
+class SPSCQueue {
+public:
+    // capacity is rounded up to a power of two
+    explicit SPSCQueue(size_t capacity)
+        : slots_(roundUp(capacity))
+        , mask_(slots_.size() - 1)
+    {
+    }
+    ~SPSCQueue() = default;
+
+    SPSCQueue(const SPSCQueue&)            = delete;
+    SPSCQueue(SPSCQueue&&)                 = delete;
+    SPSCQueue& operator=(const SPSCQueue&) = delete;
+    SPSCQueue& operator=(SPSCQueue&&)      = delete;
+
+    // producer only, false if the queue is full
+    bool tryPush(const T& value)
+    {
+        auto tail = tail_.load(std::memory_order_relaxed);
+        if (tail - headCache_ == slots_.size()) {
+            headCache_ = head_.load(std::memory_order_acquire);
+            if (tail - headCache_ == slots_.size()) {
+                return false;
+            }
+        }
+        slots_[tail & mask_] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        notify();
+        return true;
+    }
+
+    // consumer only, false if the queue is empty
+    bool tryPop(T& value)
+    {
+        auto head = head_.load(std::memory_order_relaxed);
+        if (head == tailCache_) {
+            tailCache_ = tail_.load(std::memory_order_acquire);
+            if (head == tailCache_) {
+                return false;
+            }
+        }
+        value = slots_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        notify();
+        return true;
+    }
+
+    // producer only, blocks until tryPush can succeed
+    void waitNotFull()
+    {
+        wait([this] { return size() != slots_.size(); });
+    }
+
+    // consumer only, blocks until tryPop can succeed
+    void waitNotEmpty()
+    {
+        wait([this] { return size() != 0; });
+    }
+
+    // element count, exact only if called by a side while the other side is idle
+    inline size_t size() const
+    {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    inline size_t capacity() const { return slots_.size(); }
+
+private:
+    static size_t roundUp(size_t capacity)
+    {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        return size;
+    }
+
+    template <typename Pred>
+    void wait(Pred ready)
+    {
+        waiters_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait(lock, ready);
+        }
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // wake the other side if it waits for the index just stored
+    void notify()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) != 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cond_.notify_all();
+        }
+    }
+
+private:
+    std::vector<T> slots_;
+    size_t         mask_;
+
+    alignas(64) std::atomic<size_t> head_ { 0 }; // written by the consumer
+    size_t tailCache_ { 0 };                     // consumer copy of tail_
+
+    alignas(64) std::atomic<size_t> tail_ { 0 }; // written by the producer
+    size_t headCache_ { 0 };                     // producer copy of head_
+
+    alignas(64) std::atomic<int> waiters_ { 0 }; // sides blocked in wait()
+    std::mutex              mutex_;
+    std::condition_variable cond_;
+};
+
+} // namespace ANSI
@@ -0,0 +1,138 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include "Scrollback.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+namespace ANSI {
+
+// runs are stored first, so every line starts at a multiple of their alignment
+static constexpr size_t LINE_ALIGN = alignof(PackedRun);
+
+static size_t lineBytes(size_t textLen, size_t runCnt)
+{
+    size_t bytes = runCnt * sizeof(PackedRun) + textLen;
+    return (bytes + LINE_ALIGN - 1) / LINE_ALIGN * LINE_ALIGN;
+}
+
+Scrollback::Scrollback(const TextAttribute& defaultAttr, const TextAttribute& currentAttr, size_t maxLines,
+                       size_t maxBytes)
+    : parser_(defaultAttr, currentAttr)
+    , cap_(std::min<size_t>(maxBytes, UINT32_MAX) / LINE_ALIGN * LINE_ALIGN)
+    , head_(0)
+    , tail_(0)
+    , used_(0)
+    , lines_(std::max<size_t>(maxLines, 1))
+    , firstLine_(0)
+    , lineCnt_(0)
+{
+    arena_ = std::make_unique<char[]>(cap_);
+}
+
+bool Scrollback::append(std::string_view line)
+{
+    // text between sequences with the same attribute is one run
+    struct Visitor {
+        std::string&            text;
+        std::vector<PackedRun>& runs;
+
+        void onText(std::string_view view, const TextAttribute& attr)
+        {
+            text.append(view);
+            if (!runs.empty() && runs.back().attr() == attr) {
+                runs.back().len += uint32_t(view.size());
+                return;
+            }
+            runs.push_back({ uint32_t(view.size()), uint8_t(attr.state), attr.color.front, attr.color.back });
+        }
+
+        void onAttrChange(const TextAttribute&, const TextAttribute&) {}
+    };
+
+    text_.clear();
+    runs_.clear();
+    parser_.visit(line, Visitor { text_, runs_ }, TextParser::Mode::ALL_TEXT);
+
+    size_t need = lineBytes(text_.size(), runs_.size());
+    if (need > cap_) {
+        return false;
+    }
+    if (lineCnt_ == lines_.size()) {
+        evict();
+    }
+
+    size_t charge;
+    size_t offset = allocate(need, charge);
+    char*  data   = arena_.get() + offset;
+    std::uninitialized_copy(runs_.begin(), runs_.end(), reinterpret_cast<PackedRun*>(data));
+    std::memcpy(data + runs_.size() * sizeof(PackedRun), text_.data(), text_.size());
+    tail_ = offset + need;
+    used_ += charge;
+
+    lines_[(firstLine_ + lineCnt_) % lines_.size()] = { uint32_t(offset), uint32_t(charge), uint32_t(text_.size()),
+                                                         uint32_t(runs_.size()) };
+    ++lineCnt_;
+    return true;
+}
+
+ScrollbackLine Scrollback::operator[](size_t index) const
+{
+    const auto& line = lines_[(firstLine_ + index) % lines_.size()];
+    const char* data = arena_.get() + line.offset;
+    auto        runs = reinterpret_cast<const PackedRun*>(data);
+    return { { data + line.runCnt * sizeof(PackedRun), line.textLen }, runs, line.runCnt };
+}
+
+void Scrollback::clear()
+{
+    head_      = 0;
+    tail_      = 0;
+    used_      = 0;
+    firstLine_ = 0;
+    lineCnt_   = 0;
+}
+
+size_t Scrollback::allocate(size_t need, size_t& charge)
+{
+    // free bytes are [tail, cap) and [0, head) if the data does not wrap, else [tail, head)
+    while (true) {
+        if (used_ == 0) {
+            head_ = 0;
+            tail_ = 0;
+        }
+        if (tail_ > head_ || used_ == 0) {
+            if (cap_ - tail_ >= need) {
+                charge = need;
+                return tail_;
+            }
+            // the end of the arena is left unused until this line is evicted
+            if (head_ >= need) {
+                charge = cap_ - tail_ + need;
+                return 0;
+            }
+        }
+        else if (head_ - tail_ >= need) {
+            charge = need;
+            return tail_;
+        }
+        evict();
+    }
+}
+
+void Scrollback::evict()
+{
+    const auto& line = lines_[firstLine_];
+    // an empty line takes no bytes, its offset may be stale
+    if (line.bytes != 0) {
+        head_ = line.offset + lineBytes(line.textLen, line.runCnt);
+        used_ -= line.bytes;
+    }
+    firstLine_ = (firstLine_ + 1) % lines_.size();
+    --lineCnt_;
+}
+
+} // namespace ANSI
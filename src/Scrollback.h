@@ -0,0 +1,150 @@
+//
+// Created by marvin on 26-10-17.
+//
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "TextParser.h"
+
+namespace ANSI {
+
+// a run of a Scrollback line in 12 bytes, start is the sum of len of the runs before it
+struct PackedRun {
+    uint32_t len;
+    uint8_t  state;
+    RGB      front;
+    RGB      back;
+
+    inline TextAttribute attr() const { return { TextAttribute::State(state), { front, back } }; }
+};
+
+// a run of a Scrollback line as TextParser emits it, start is relative to the line
+struct ScrollbackRun {
+    TextAttribute attr;
+    size_t        start;
+    size_t        len;
+};
+
+// one line of a Scrollback, valid until the next append()
+struct ScrollbackLine {
+    class Iterator {
+    public:
+        inline Iterator(const PackedRun* run, size_t start)
+            : run_(run)
+            , start_(start)
+        {
+        }
+
+        inline ScrollbackRun operator*() const { return { run_->attr(), start_, run_->len }; }
+
+        inline Iterator& operator++()
+        {
+            start_ += run_->len;
+            ++run_;
+            return *this;
+        }
+
+        inline bool operator!=(const Iterator& other) const { return run_ != other.run_; }
+
+    private:
+        const PackedRun* run_;
+        size_t           start_;
+    };
+
+    std::string_view text;
+    const PackedRun* runs;
+    size_t           runCnt;
+
+    inline Iterator begin() const { return { runs, 0 }; }
+    inline Iterator end() const { return { runs + runCnt, text.size() }; }
+};
+
+/*
+ * The last lines of a terminal in bounded memory.
+ *
+ * The runs and text of every line are stored next to each other in one ring arena of maxBytes. Appending a line
+ * evicts the oldest lines until it fits, so memory does not grow once the arena is full, whatever the attributes
+ * are, and every line is copied once.
+ *
+ * Lines are parsed in ALL_TEXT mode and the attribute is carried from line to line. Adjacent runs with the same
+ * attribute are merged and empty runs are dropped, so the runs are the ones of TextParser::parse with coalescing.
+ */
+class Scrollback {
+public:
+    /*
+     * @param maxLines  most lines kept
+     * @param maxBytes  size of the arena, at most 4 GiB. A line takes its text and 12 bytes per run,
+     *                  rounded up to 4 bytes
+     */
+    Scrollback(const TextAttribute& defaultAttr, const TextAttribute& currentAttr, size_t maxLines, size_t maxBytes);
+    ~Scrollback() = default;
+
+    Scrollback(const Scrollback&)            = delete;
+    Scrollback(Scrollback&&)                 = delete;
+    Scrollback& operator=(const Scrollback&) = delete;
+    Scrollback& operator=(Scrollback&&)      = delete;
+
+    /*
+     * @param line  one line with control sequences, without '\n'
+     * @return      false if the parsed line is larger than the arena, it is not stored then.
+     *              The attribute is changed by the line anyway
+     */
+    bool append(std::string_view line);
+
+    // lines from the oldest one, 0 <= index < size()
+    ScrollbackLine operator[](size_t index) const;
+
+    inline size_t size() const { return lineCnt_; }
+
+    inline bool empty() const { return lineCnt_ == 0; }
+
+    // bytes of the arena used by lines
+    inline size_t usedBytes() const { return used_; }
+
+    inline size_t maxBytes() const { return cap_; }
+
+    inline size_t maxLines() const { return lines_.size(); }
+
+    // the attribute is kept
+    void clear();
+
+    inline const TextAttribute& currentTextAttr() const { return parser_.currentTextAttr(); }
+
+private:
+    struct Line {
+        uint32_t offset; // of the runs, text follows them
+        uint32_t bytes;  // arena bytes freed by eviction, including the unused end of the arena if it wraps
+        uint32_t textLen;
+        uint32_t runCnt;
+    };
+
+    /*
+     * Old lines are evicted until need bytes are free in one piece.
+     *
+     * @param charge    bytes used by the allocation, more than need if the unused end of the arena is skipped
+     * @return          offset of the bytes
+     */
+    size_t allocate(size_t need, size_t& charge);
+
+    void evict();
+
+private:
+    TextParser              parser_;
+    std::string             text_; // parsed text of the line being appended
+    std::vector<PackedRun>  runs_; // parsed runs of the line being appended
+    std::unique_ptr<char[]> arena_;
+    size_t                  cap_;
+    size_t                  head_; // start of the oldest line data
+    size_t                  tail_; // end of the newest line data
+    size_t                  used_;
+    std::vector<Line>       lines_; // ring of maxLines
+    size_t                  firstLine_;
+    size_t                  lineCnt_;
+};
+
+} // namespace ANSI
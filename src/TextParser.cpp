@@ -0,0 +1,390 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include "TextParser.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+
+namespace ANSI {
+
+ColorfulTextView ColorfulTextBuffer::operator[](size_t line) const
+{
+    const auto& cur       = lines_[line];
+    bool        isLast    = line + 1 == lines_.size();
+    size_t      textEnd   = isLast ? text_.size() : lines_[line + 1].textStart;
+    size_t      colorEnd  = isLast ? color_.size() : lines_[line + 1].colorStart;
+    auto        textStart = cur.textStart;
+
+    return { std::string_view { text_ }.substr(textStart, textEnd - textStart), color_.data() + cur.colorStart,
+             colorEnd - cur.colorStart };
+}
+
+TextParser::TextParser(const TextAttribute& defaultAttr, const TextAttribute& currentAttr)
+    : currentTextAttr_(currentAttr)
+    , sgrParser_(defaultAttr)
+{
+}
+
+ColorfulText TextParser::parse(std::string_view string, Mode mode)
+{
+    ColorfulText colorfulText;
+
+    sgrSeqs_.clear();
+    CSIScanner::scan(string, colorfulText.text, sgrSeqs_);
+    auto& colors = colorfulText.color;
+    parseSequences(mode, colorfulText.text.size(), [&colors](const TextAttribute& attr, size_t start, size_t len) {
+        colors.push_back({ attr.color, start, len });
+    });
+    return colorfulText;
+}
+
+std::vector<ColorfulText> TextParser::parse(const std::vector<std::string>& strings, Mode mode)
+{
+    std::vector<ColorfulText> textList;
+    textList.reserve(strings.size());
+    for (const auto& string : strings) {
+        textList.emplace_back(parse(string, mode));
+    }
+    return textList;
+}
+
+PmrColorfulText TextParser::parse(std::string_view string, std::pmr::memory_resource* resource, Mode mode)
+{
+    PmrColorfulText colorfulText { std::pmr::string(resource), std::pmr::vector<TextColorAttr>(resource) };
+
+    text_.clear();
+    sgrSeqs_.clear();
+    CSIScanner::scan(string, text_, sgrSeqs_);
+    colorfulText.text.assign(text_);
+
+    // one run before every sequence and one after the last one at most
+    auto& colors = colorfulText.color;
+    colors.reserve(sgrSeqs_.size() + 1);
+    parseSequences(mode, text_.size(), [&colors](const TextAttribute& attr, size_t start, size_t len) {
+        colors.push_back({ attr.color, start, len });
+    });
+    return colorfulText;
+}
+
+std::pmr::vector<PmrColorfulText> TextParser::parse(const std::vector<std::string>& strings,
+                                                    std::pmr::memory_resource* resource, Mode mode)
+{
+    std::pmr::vector<PmrColorfulText> textList(resource);
+    textList.reserve(strings.size());
+    for (const auto& string : strings) {
+        textList.emplace_back(parse(string, resource, mode));
+    }
+    return textList;
+}
+
+// a chunk smaller than this is not worth a thread
+static constexpr size_t MIN_PARALLEL_LINES = 256;
+
+// effect of all SGR sequences of text, applied after transform
+static TextAttributeTransform transformOf(SGRParser& sgrParser, std::string_view text, TextAttributeTransform transform)
+{
+    CSIScanner::visit(
+        text, [](std::string_view) {},
+        [&](std::string_view sequence) {
+            CSISequence seq { 0, sequence };
+            if (seq.finalByte() == CSIFinalBytes::SGR) {
+                transform = transform.then(sgrParser.parseSGRTransform(seq.parameters()).second);
+            }
+        });
+    return transform;
+}
+
+// effect of all SGR sequences of the lines, text is skipped
+static TextAttributeTransform transformOf(SGRParser& sgrParser, const std::string* begin, const std::string* end)
+{
+    TextAttributeTransform transform { 0, sgrParser.defaultTextAttr() };
+    for (auto line = begin; line != end; ++line) {
+        transform = transformOf(sgrParser, *line, transform);
+    }
+    return transform;
+}
+
+std::vector<ColorfulText> TextParser::parseParallel(const std::vector<std::string>& strings, Mode mode,
+                                                    size_t threadCnt)
+{
+    if (threadCnt == 0) {
+        threadCnt = std::max(1u, std::thread::hardware_concurrency());
+    }
+    size_t chunkCnt = std::min(threadCnt, strings.size() / MIN_PARALLEL_LINES);
+    if (chunkCnt <= 1) {
+        return parse(strings, mode);
+    }
+
+    // chunkAttr is the attribute at the start of a chunk, chunkEnd is the attribute after parsing it
+    std::vector<ColorfulText>           textList(strings.size());
+    std::vector<size_t>                 chunkBegin(chunkCnt + 1);
+    std::vector<TextAttribute>          chunkAttr(chunkCnt);
+    std::vector<TextAttribute>          chunkEnd(chunkCnt);
+    std::vector<TextAttributeTransform> chunkTransform(chunkCnt, { 0, sgrParser_.defaultTextAttr() });
+    std::vector<bool>                   transformed(chunkCnt, false);
+    for (size_t i = 0; i <= chunkCnt; ++i) {
+        chunkBegin[i] = strings.size() * i / chunkCnt;
+    }
+
+    // chunkAttr[0, knownAttrCnt) are known, the next one needs the transform of the chunk before it
+    std::mutex              mutex;
+    std::condition_variable attrKnown;
+    size_t                  knownAttrCnt = 1;
+    chunkAttr[0]                         = currentTextAttr_;
+
+    const auto& defaultAttr = sgrParser_.defaultTextAttr();
+    const bool  useCache    = sgrParser_.cache() != nullptr;
+    auto        runChunk    = [&](size_t chunk) {
+        // the transform of the last chunk is not needed by any chunk
+        if (chunk + 1 < chunkCnt) {
+            SGRParser sgrParser(defaultAttr);
+            sgrParser.enableCache(useCache);
+            auto transform = transformOf(sgrParser, strings.data() + chunkBegin[chunk],
+                                         strings.data() + chunkBegin[chunk + 1]);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            chunkTransform[chunk] = transform;
+            transformed[chunk]    = true;
+            while (knownAttrCnt < chunkCnt && transformed[knownAttrCnt - 1]) {
+                chunkAttr[knownAttrCnt] = chunkTransform[knownAttrCnt - 1].apply(chunkAttr[knownAttrCnt - 1]);
+                ++knownAttrCnt;
+            }
+            attrKnown.notify_all();
+        }
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            attrKnown.wait(lock, [&] { return knownAttrCnt > chunk; });
+        }
+
+        TextParser parser(defaultAttr, chunkAttr[chunk]);
+        parser.sgrParser().enableCache(useCache);
+        parser.enableCoalesce(coalesce_);
+        for (size_t i = chunkBegin[chunk]; i < chunkBegin[chunk + 1]; ++i) {
+            textList[i] = parser.parse(strings[i], mode);
+        }
+        chunkEnd[chunk] = parser.currentTextAttr();
+    };
+
+    // one thread per chunk first finds the transform of its chunk, then parses it once its start attribute is known
+    std::vector<std::thread> threads;
+    threads.reserve(chunkCnt - 1);
+    for (size_t chunk = 1; chunk < chunkCnt; ++chunk) {
+        threads.emplace_back(runChunk, chunk);
+    }
+    runChunk(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    currentTextAttr_ = chunkEnd[chunkCnt - 1];
+    return textList;
+}
+
+TextAttributeTransform TextParser::transform(std::string_view text)
+{
+    return transformOf(sgrParser_, text, { 0, sgrParser_.defaultTextAttr() });
+}
+
+ColorfulTextView TextParser::parse(std::string_view string, ColorfulTextBuffer& buffer, Mode mode)
+{
+    size_t textStart = buffer.text_.size();
+    buffer.lines_.push_back({ textStart, buffer.color_.size() });
+
+    sgrSeqs_.clear();
+    CSIScanner::scan(string, buffer.text_, sgrSeqs_);
+    auto& colors   = buffer.color_;
+    auto  textSize = buffer.text_.size() - textStart;
+    parseSequences(mode, textSize, [&colors](const TextAttribute& attr, size_t start, size_t len) {
+        colors.push_back({ attr.color, start, len });
+    });
+    return buffer[buffer.size() - 1];
+}
+
+CompactText TextParser::parse(std::string_view string, AttributeTable& table, Mode mode)
+{
+    CompactText compactText;
+
+    sgrSeqs_.clear();
+    CSIScanner::scan(string, compactText.text, sgrSeqs_);
+    parseSequences(mode, compactText.text.size(), [&](const TextAttribute& attr, size_t start, size_t len) {
+        compactText.runs.push_back({ uint32_t(start), uint32_t(len), table.intern(attr) });
+    });
+    return compactText;
+}
+
+ColumnText TextParser::parseColumns(std::string_view string, Mode mode)
+{
+    ColumnText columnText;
+    auto&      text = columnText.text;
+    text.reserve(string.size());
+
+    sgrSeqs_.clear();
+    seqWidths_.clear();
+    TextWidth total { 0, 0 };
+    CSIScanner::visit(
+        string,
+        [&](std::string_view block) {
+            auto width = UTF8::measure(block);
+            total.codePoints += width.codePoints;
+            total.columns += width.columns;
+            text.append(block);
+        },
+        [&](std::string_view sequence) {
+            sgrSeqs_.push_back({ text.size(), sequence });
+            seqWidths_.push_back(total);
+        });
+
+    // runs are emitted in order, so the sequence at a run boundary is found by walking forward
+    size_t next    = 0;
+    auto   widthAt = [&](size_t pos) {
+        if (pos == 0) {
+            return TextWidth { 0, 0 };
+        }
+        while (next < sgrSeqs_.size() && sgrSeqs_[next].pos < pos) {
+            ++next;
+        }
+        return next < sgrSeqs_.size() && sgrSeqs_[next].pos == pos ? seqWidths_[next] : total;
+    };
+    parseSequences(mode, text.size(), [&](const TextAttribute& attr, size_t start, size_t len) {
+        auto before = widthAt(start);
+        auto after  = widthAt(start + len);
+        columnText.color.push_back({ attr.color, start, len });
+        columnText.columns.push_back({ before.codePoints, after.codePoints - before.codePoints, before.columns,
+                                       after.columns - before.columns });
+    });
+    return columnText;
+}
+
+template <typename Emit>
+void TextParser::parseSequences(Mode mode, size_t textSize, Emit&& emit)
+{
+    if (!coalesce_) {
+        parseRuns(mode, textSize, emit);
+        return;
+    }
+
+    // a run is held back until a run with another attribute or a gap before it follows
+    TextAttribute runAttr {};
+    size_t        runStart = 0;
+    size_t        runLen   = 0;
+    parseRuns(mode, textSize, [&](const TextAttribute& attr, size_t start, size_t len) {
+        if (len == 0) {
+            return;
+        }
+        if (runLen != 0 && runStart + runLen == start && runAttr == attr) {
+            runLen += len;
+            return;
+        }
+        if (runLen != 0) {
+            emit(runAttr, runStart, runLen);
+        }
+        runAttr  = attr;
+        runStart = start;
+        runLen   = len;
+    });
+    if (runLen != 0) {
+        emit(runAttr, runStart, runLen);
+    }
+}
+
+template <typename Emit>
+void TextParser::parseRuns(Mode mode, size_t textSize, Emit&& emit)
+{
+    if (mode == Mode::ALL_TEXT) {
+        allStringToText(sgrSeqs_, textSize, emit);
+    }
+    else if (mode == Mode::MARKED_TEXT) {
+        markedStringToText(sgrSeqs_, textSize, emit);
+    }
+}
+
+template <typename Emit>
+void TextParser::markedStringToText(const std::vector<CSISequence>& sgrSeqs, size_t textSize, Emit&& emit)
+{
+    // empty SGR sequences process
+    if (sgrSeqs.empty()) {
+        if (currentTextAttr_.state == TextAttribute::State::CUSTOM) {
+            emit(currentTextAttr_, 0, textSize);
+        }
+        return;
+    }
+
+    // get first colorful text pos and attribute
+    auto firstResult = sgrParser_.parseSGRSequence(currentTextAttr_, sgrSeqs[0].sequence);
+    auto curPos      = sgrSeqs[0].pos;
+    auto curTextAttr = firstResult.second;
+
+    for (size_t i = 0; i < sgrSeqs.size(); ++i) {
+        // if exist next colorful text , parse sequence
+        // else set next pos to string end
+        size_t                nextPos;
+        decltype(curTextAttr) nextTextAttr;
+        if (i + 1 < sgrSeqs.size()) {
+            auto result  = sgrParser_.parseSGRSequence(curTextAttr, sgrSeqs[i + 1].sequence);
+            nextPos      = sgrSeqs[i + 1].pos;
+            nextTextAttr = result.second;
+        }
+        else {
+            nextPos      = textSize;
+            nextTextAttr = curTextAttr;
+        }
+
+        if (curTextAttr.state == TextAttribute::State::CUSTOM) {
+            emit(curTextAttr, curPos, nextPos - curPos);
+        }
+
+        curPos      = nextPos;
+        curTextAttr = nextTextAttr;
+    }
+    currentTextAttr_ = curTextAttr;
+}
+
+template <typename Emit>
+void TextParser::allStringToText(const std::vector<CSISequence>& sgrSeqs, size_t textSize, Emit&& emit)
+{
+    // empty SGR sequences process
+    if (sgrSeqs.empty()) {
+        emit(currentTextAttr_, 0, textSize);
+        return;
+    }
+
+    size_t curPos      = 0;
+    auto   curTextAttr = currentTextAttr_;
+
+    // first text push back
+    auto firstResult  = sgrParser_.parseSGRSequence(curTextAttr, sgrSeqs[0].sequence);
+    auto nextPos      = sgrSeqs[0].pos;
+    auto nextTextAttr = firstResult.second;
+    if (curPos < nextPos) {
+        emit(curTextAttr, curPos, nextPos - curPos);
+    }
+
+    // update context
+    curPos      = nextPos;
+    curTextAttr = nextTextAttr;
+
+    for (size_t i = 0; i < sgrSeqs.size(); ++i) {
+        if (i + 1 < sgrSeqs.size()) {
+            auto result  = sgrParser_.parseSGRSequence(curTextAttr, sgrSeqs[i + 1].sequence);
+            nextPos      = sgrSeqs[i + 1].pos;
+            nextTextAttr = result.second;
+        }
+        else {
+            nextPos      = textSize;
+            nextTextAttr = curTextAttr;
+        }
+
+        emit(curTextAttr, curPos, nextPos - curPos);
+
+        curPos      = nextPos;
+        curTextAttr = nextTextAttr;
+    }
+    currentTextAttr_ = curTextAttr;
+}
+
+} // namespace ANSI
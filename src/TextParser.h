@@ -0,0 +1,254 @@
+//
+// Created by marvin on 26-10-17.
+//
+#pragma once
+
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "AttributeTable.h"
+#include "CSIScanner.h"
+#include "SGRParser.h"
+#include "UTF8.h"
+
+namespace ANSI {
+
+struct TextColorAttr {
+    Color  color;
+    size_t start;
+    size_t len;
+};
+
+struct ColorfulText {
+    std::string                text;
+    std::vector<TextColorAttr> color;
+};
+
+// ColorfulText allocated from a memory resource, example: a std::pmr::monotonic_buffer_resource per request
+struct PmrColorfulText {
+    std::pmr::string                text;
+    std::pmr::vector<TextColorAttr> color;
+};
+
+// position of a run in code points and terminal columns of the text, see UTF8::measure
+struct TextColumnAttr {
+    size_t codePointStart;
+    size_t codePointLen;
+    size_t columnStart;
+    size_t columnLen;
+};
+
+// ColorfulText with the columns of the runs, columns[i] is the position of color[i]
+struct ColumnText {
+    std::string                 text;
+    std::vector<TextColorAttr>  color;
+    std::vector<TextColumnAttr> columns;
+};
+
+// ColorfulText with runs of an AttributeTable
+struct CompactText {
+    std::string             text;
+    std::vector<CompactRun> runs;
+};
+
+/*
+ * One line of a ColorfulTextBuffer, start of color is relative to text.
+ *
+ * It points into the buffer, so it is only valid until the buffer is changed or destroyed.
+ */
+struct ColorfulTextView {
+    std::string_view     text;
+    const TextColorAttr* color;
+    size_t               colorCnt;
+
+    inline const TextColorAttr* begin() const { return color; }
+    inline const TextColorAttr* end() const { return color + colorCnt; }
+};
+
+/*
+ * Parse results of many lines in one text buffer and one color buffer.
+ *
+ * clear() keeps the memory, so a reused buffer does not allocate once it is large enough.
+ */
+class ColorfulTextBuffer {
+    friend class TextParser;
+
+public:
+    ColorfulTextBuffer()  = default;
+    ~ColorfulTextBuffer() = default;
+
+    inline void clear()
+    {
+        text_.clear();
+        color_.clear();
+        lines_.clear();
+    }
+
+    inline size_t size() const { return lines_.size(); }
+
+    inline bool empty() const { return lines_.empty(); }
+
+    ColorfulTextView operator[](size_t line) const;
+
+    // text of all lines without control sequences
+    inline std::string_view text() const { return text_; }
+
+private:
+    struct Line {
+        size_t textStart;
+        size_t colorStart;
+    };
+
+    std::string                text_;
+    std::vector<TextColorAttr> color_;
+    std::vector<Line>          lines_;
+};
+
+class TextParser {
+public:
+    enum class Mode {
+        MARKED_TEXT,
+        ALL_TEXT,
+    };
+
+public:
+    TextParser(const TextAttribute& defaultAttr, const TextAttribute& currentAttr);
+    ~TextParser() = default;
+
+    TextParser(const TextParser&)            = delete;
+    TextParser(TextParser&&)                 = delete;
+    TextParser& operator=(const TextParser&) = delete;
+    TextParser& operator=(TextParser&&)      = delete;
+
+    ColorfulText parse(std::string_view string, Mode mode = Mode::ALL_TEXT);
+
+    std::vector<ColorfulText> parse(const std::vector<std::string>& strings, Mode mode = Mode::ALL_TEXT);
+
+    /*
+     * Same result as parse(string, mode), all memory of the result is allocated from resource.
+     *
+     * The text is scanned into a buffer of the parser first and copied once, and the color vector is reserved
+     * for the most runs the line can have, so a monotonic resource does not keep memory of grown buffers.
+     */
+    PmrColorfulText parse(std::string_view string, std::pmr::memory_resource* resource, Mode mode = Mode::ALL_TEXT);
+
+    std::pmr::vector<PmrColorfulText> parse(const std::vector<std::string>& strings,
+                                            std::pmr::memory_resource* resource, Mode mode = Mode::ALL_TEXT);
+
+    /*
+     * Same result as parse(strings, mode), lines are split into threadCnt chunks which are parsed in parallel.
+     *
+     * The attribute at the start of every chunk is found by composing the TextAttributeTransform of the chunks
+     * before it, which only needs the SGR sequences and not the output. Every chunk has one thread which finds
+     * the transform of its chunk and then parses it as soon as the transforms before it are done.
+     *
+     * @param threadCnt     0 means std::thread::hardware_concurrency()
+     */
+    std::vector<ColorfulText> parseParallel(const std::vector<std::string>& strings, Mode mode = Mode::ALL_TEXT,
+                                            size_t threadCnt = 0);
+
+    /*
+     * @param string    one line
+     * @param buffer    parse result is appended to it as a new line
+     * @return          the new line, valid until buffer is changed
+     */
+    ColorfulTextView parse(std::string_view string, ColorfulTextBuffer& buffer, Mode mode = Mode::ALL_TEXT);
+
+    /*
+     * @param string    one line
+     * @param table     attributes of the runs are interned into it
+     * @return          text and runs with attribute ids of table
+     */
+    CompactText parse(std::string_view string, AttributeTable& table, Mode mode = Mode::ALL_TEXT);
+
+    /*
+     * Same result as parse(string, mode) with the code points and terminal columns of every run, so a renderer
+     * does not need to scan the text again. Start and len of color are UTF-8 byte offsets.
+     *
+     * The text between control sequences is measured while it is scanned, runs start and end at sequences, so the
+     * text is read once. A sequence ends a UTF-8 sequence which it cuts, like it does in a terminal: every byte
+     * before it is one invalid code point.
+     */
+    ColumnText parseColumns(std::string_view string, Mode mode = Mode::ALL_TEXT);
+
+    /*
+     * Parse one line without building results, nothing is allocated.
+     *
+     * @param string    one line, text views point into it
+     * @param visitor   visitor.onText(std::string_view text, const TextAttribute& attr) is called for the text
+     *                  between control sequences, in MARKED_TEXT mode only for custom text.
+     *                  visitor.onAttrChange(const TextAttribute& old, const TextAttribute& now) is called when
+     *                  an SGR sequence changes the attribute.
+     */
+    template <typename Visitor>
+    void visit(std::string_view string, Visitor&& visitor, Mode mode = Mode::ALL_TEXT)
+    {
+        CSIScanner::visit(
+            string,
+            [&](std::string_view text) {
+                if (!text.empty()
+                    && (mode == Mode::ALL_TEXT || currentTextAttr_.state == TextAttribute::State::CUSTOM)) {
+                    visitor.onText(text, currentTextAttr_);
+                }
+            },
+            [&](std::string_view sequence) {
+                CSISequence seq { 0, sequence };
+                if (seq.finalByte() != CSIFinalBytes::SGR) {
+                    return;
+                }
+                auto attr = sgrParser_.parseSGRParameters(currentTextAttr_, seq.parameters()).second;
+                if (attr != currentTextAttr_) {
+                    auto old         = currentTextAttr_;
+                    currentTextAttr_ = attr;
+                    visitor.onAttrChange(old, currentTextAttr_);
+                }
+            });
+    }
+
+    /*
+     * Effect of all SGR sequences of text, the text itself is skipped and currentTextAttr() is not changed.
+     *
+     * transform(text).apply(currentTextAttr()) is the attribute after parsing text.
+     */
+    TextAttributeTransform transform(std::string_view text);
+
+    inline const TextAttribute& currentTextAttr() const { return currentTextAttr_; }
+
+    // SGR parser of the lines, example: enable its cache
+    inline SGRParser& sgrParser() { return sgrParser_; }
+
+    /*
+     * Merge adjacent runs with the same attribute and drop empty runs, enabled by default.
+     *
+     * Example: "\033[31mfoo\033[31mbar" is one run instead of two. The visitor of visit() is not affected, it is
+     * only called for changes and text which is not empty.
+     */
+    inline void enableCoalesce(bool enable) { coalesce_ = enable; }
+
+    inline bool coalesce() const { return coalesce_; }
+
+private:
+    // parse sgrSeqs_ of a text which size is textSize, emit(attr, start, len) is called for every run
+    template <typename Emit>
+    void parseSequences(Mode mode, size_t textSize, Emit&& emit);
+    template <typename Emit>
+    void parseRuns(Mode mode, size_t textSize, Emit&& emit);
+
+    // sgrSeqs position is relative to text
+    template <typename Emit>
+    void markedStringToText(const std::vector<CSISequence>& sgrSeqs, size_t textSize, Emit&& emit);
+    template <typename Emit>
+    void allStringToText(const std::vector<CSISequence>& sgrSeqs, size_t textSize, Emit&& emit);
+
+private:
+    TextAttribute            currentTextAttr_;
+    SGRParser                sgrParser_;
+    std::vector<CSISequence> sgrSeqs_;
+    std::vector<TextWidth>   seqWidths_; // width of the text before every sequence of parseColumns
+    std::string              text_;      // scanned text of the pmr parse
+    bool                     coalesce_ = true;
+};
+
+} // namespace ANSI
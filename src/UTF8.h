@@ -0,0 +1,47 @@
+//
+// Created by marvin on 26-10-17.
+//
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace ANSI {
+
+// size of a text in code points and in terminal columns
+struct TextWidth {
+    size_t codePoints;
+    size_t columns;
+};
+
+class UTF8 {
+public:
+    // replaces an invalid byte
+    static constexpr char32_t REPLACEMENT = 0xFFFD;
+
+public:
+    UTF8()  = delete;
+    ~UTF8() = delete;
+
+    /*
+     * @param cur   first byte of a code point, moved to the next code point
+     * @param end   end of the text, cur < end
+     * @return      the code point, REPLACEMENT for an invalid, overlong or cut sequence which takes one byte then
+     */
+    static char32_t decode(const char*& cur, const char* end);
+
+    /*
+     * Terminal columns of a code point, like wcwidth():
+     * 0 for control characters, combining marks and other zero width characters,
+     * 2 for East Asian Wide and Fullwidth characters, 1 for the others.
+     */
+    static int columnsOf(char32_t codePoint);
+
+    /*
+     * Printable ASCII is skipped in blocks by SIMD::findNonPrintableASCII, the other bytes are decoded.
+     * An invalid byte is one code point of 1 column, like REPLACEMENT.
+     */
+    static TextWidth measure(std::string_view text);
+};
+
+} // namespace ANSI
@@ -0,0 +1,80 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include "AttributeTable.h"
+#include "test_support.h"
+
+using namespace ANSI;
+
+static void testIntern()
+{
+    AttributeTable table;
+    TextAttribute  red { TextAttribute::State::CUSTOM, { { 222, 56, 43 }, { 255, 255, 255 } } };
+    TextAttribute  defaultRed { TextAttribute::State::DEFAULT, red.color };
+
+    CHECK(table.intern(defaultAttr) == 0);
+    CHECK(table.intern(red) == 1);
+    CHECK(table.intern(red) == 1);
+    CHECK(table.intern(defaultAttr) == 0);
+
+    // the state is part of the key, not only the colors
+    CHECK(table.intern(defaultRed) == 2);
+    CHECK(table.size() == 3);
+    CHECK(table.resolve(0) == defaultAttr);
+    CHECK(table.resolve(1) == red);
+    CHECK(table.resolve(2) == defaultRed);
+
+    table.clear();
+    CHECK(table.size() == 0);
+    CHECK(table.intern(red) == 0);
+}
+
+// an id keeps its attribute while many others are interned after it
+static void testStableIds()
+{
+    AttributeTable             table;
+    std::vector<TextAttribute> attrs;
+    for (int i = 0; i < 5000; ++i) {
+        attrs.push_back({ TextAttribute::State(i % 2),
+                          { { uint8_t(i), uint8_t(i >> 8), 7 }, { 1, uint8_t(i * 3), uint8_t(i >> 4) } } });
+    }
+    for (size_t i = 0; i < attrs.size(); ++i) {
+        CHECK(table.intern(attrs[i]) == AttributeId(i));
+    }
+    for (size_t i = attrs.size(); i-- > 0;) {
+        CHECK(table.intern(attrs[i]) == AttributeId(i));
+        CHECK(table.resolve(AttributeId(i)) == attrs[i]);
+    }
+    CHECK(table.size() == attrs.size());
+}
+
+// the compact runs resolve to the runs of parse(string)
+static void testCompactParse()
+{
+    TokenGenerator generator(51);
+    auto           lines = generator.lines(3000, 10);
+
+    AttributeTable table;
+    TextParser     parser(defaultAttr, defaultAttr);
+    TextParser     compactParser(defaultAttr, defaultAttr);
+    for (const auto& line : lines) {
+        auto expect = parser.parse(line);
+        auto result = compactParser.parse(line, table);
+        CHECK(result.text == expect.text && result.runs.size() == expect.color.size());
+        for (size_t i = 0; i < result.runs.size() && i < expect.color.size(); ++i) {
+            const auto& run = result.runs[i];
+            CHECK(run.start == expect.color[i].start && run.len == expect.color[i].len);
+            CHECK(table.resolve(run.attrId).color == expect.color[i].color);
+        }
+    }
+    CHECK(table.size() > 1);
+}
+
+int main()
+{
+    testIntern();
+    testStableIds();
+    testCompactParse();
+    return testResult("attribute_table_test");
+}
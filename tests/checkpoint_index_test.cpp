@@ -0,0 +1,169 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include <cstdio>
+
+#include "CheckpointIndex.h"
+#include "TextParser.h"
+#include "test_support.h"
+
+using namespace ANSI;
+
+static const char* const INDEX_PATH = "checkpoint_index_test.sgridx";
+static const RGB         RED { 222, 56, 43 };
+
+// offset and attribute at the start of every line, parsed from the start of the text
+struct LineStarts {
+    std::vector<uint64_t>      offsets;
+    std::vector<TextAttribute> attrs;
+};
+
+static LineStarts parseSequential(std::string_view data)
+{
+    LineStarts result;
+    TextParser parser(defaultAttr, defaultAttr);
+    size_t     pos = 0;
+    while (true) {
+        result.offsets.push_back(pos);
+        result.attrs.push_back(parser.currentTextAttr());
+        auto lineEnd = data.find('\n', pos);
+        if (lineEnd == std::string_view::npos) {
+            break;
+        }
+        parser.parse(data.substr(pos, lineEnd - pos));
+        pos = lineEnd + 1;
+    }
+    return result;
+}
+
+static bool sameCheckpoints(const CheckpointIndex& a, const CheckpointIndex& b)
+{
+    if (a.checkpoints().size() != b.checkpoints().size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.checkpoints().size(); ++i) {
+        const auto& x = a.checkpoints()[i];
+        const auto& y = b.checkpoints()[i];
+        if (x.line != y.line || x.offset != y.offset || !(x.attr == y.attr)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void testLiterals()
+{
+    // an OSC is cancelled by '\n', so its line ends there and the sequence after it still counts
+    std::string_view data = "\033[31ma\nb\n\033]0;x\n\033[0mc\033[31m\nd\033[";
+    CheckpointIndex  index(defaultAttr, defaultAttr, 1, 0);
+    index.update(data);
+    CHECK(index.indexedSize() == data.rfind('\n') + 1);
+    CHECK(index.checkpoints().size() == 5);
+    if (index.checkpoints().size() == 5) {
+        const auto& checkpoints = index.checkpoints();
+        CHECK(checkpoints[1].line == 1 && checkpoints[1].offset == 7 && checkpoints[1].attr.color.front == RED);
+        CHECK(checkpoints[2].line == 2 && checkpoints[2].attr.color.front == RED);
+        CHECK(checkpoints[3].line == 3 && checkpoints[3].offset == 15 && checkpoints[3].attr.color.front == RED);
+        CHECK(checkpoints[4].line == 4 && checkpoints[4].attr.color.front == RED);
+    }
+
+    Checkpoint result;
+    CHECK(index.seek(data, 4, result) && result.offset == data.rfind('\n') + 1);
+    CHECK(!index.seek(data, 5, result));
+
+    // the whole lines between two checkpoints are skipped at once
+    CheckpointIndex sparse(defaultAttr, defaultAttr, 3, 0);
+    sparse.update(data);
+    CHECK(sparse.checkpoints().size() == 2 && sparse.checkpoints()[1].line == 3);
+    CHECK(sparse.checkpoints().size() == 2 && sparse.checkpoints()[1].attr.color.front == RED);
+}
+
+static void testSeek(std::string_view data, const LineStarts& starts, uint64_t lineInterval, uint64_t byteInterval,
+                     TokenGenerator& generator)
+{
+    CheckpointIndex index(defaultAttr, defaultAttr, lineInterval, byteInterval);
+    index.update(data);
+    for (const auto& checkpoint : index.checkpoints()) {
+        CHECK(checkpoint.line < starts.offsets.size());
+        CHECK(starts.offsets[checkpoint.line] == checkpoint.offset);
+        CHECK(starts.attrs[checkpoint.line] == checkpoint.attr);
+    }
+
+    for (int i = 0; i < 500; ++i) {
+        uint64_t   line = generator.uniform(starts.offsets.size() + 3);
+        Checkpoint result;
+        bool       found = index.seek(data, line, result);
+        CHECK(found == (line < starts.offsets.size()));
+        if (found) {
+            CHECK(result.line == line && result.offset == starts.offsets[line]);
+            CHECK(result.attr == starts.attrs[line]);
+        }
+    }
+
+    // a growing log indexed again and again has the same checkpoints
+    CheckpointIndex growing(defaultAttr, defaultAttr, lineInterval, byteInterval);
+    for (size_t size = 0; size < data.size(); size += 1 + generator.uniform(5000)) {
+        growing.update(data.substr(0, size));
+    }
+    growing.update(data);
+    CHECK(sameCheckpoints(growing, index));
+    CHECK(growing.indexedSize() == index.indexedSize());
+}
+
+static void testSaveLoad(std::string_view data)
+{
+    CheckpointIndex index(defaultAttr, defaultAttr, 100, 0);
+    index.update(data);
+    CHECK(index.save(INDEX_PATH));
+    // saving again replaces the file and leaves no temporary file
+    CHECK(index.save(INDEX_PATH));
+    CHECK(std::fopen((std::string(INDEX_PATH) + ".tmp").c_str(), "rb") == nullptr);
+
+    CheckpointIndex loaded(defaultAttr, defaultAttr, 1, 1);
+    CHECK(loaded.load(INDEX_PATH));
+    CHECK(sameCheckpoints(loaded, index));
+    CHECK(loaded.indexedSize() == index.indexedSize());
+    CHECK(loaded.lineInterval() == 100 && loaded.byteInterval() == 0);
+
+    // an appended log still matches, a truncated, rotated or rewritten one does not
+    std::string appended = std::string(data) + "more\n";
+    std::string rewritten(data);
+    rewritten[loaded.indexedSize() - 10] ^= 1;
+    CHECK(loaded.matches(data));
+    CHECK(loaded.matches(appended));
+    CHECK(!loaded.matches(data.substr(0, data.size() / 2)));
+    CHECK(!loaded.matches(rewritten));
+    rewritten = std::string(data);
+    rewritten[10] ^= 1;
+    CHECK(!loaded.matches(rewritten));
+
+    // a damaged file is rejected and the index is not changed
+    FILE* file = std::fopen(INDEX_PATH, "r+b");
+    CHECK(file != nullptr);
+    if (file != nullptr) {
+        std::fseek(file, -7, SEEK_END);
+        std::fputc(0x7F, file);
+        std::fclose(file);
+    }
+    CHECK(!loaded.load(INDEX_PATH));
+    CHECK(sameCheckpoints(loaded, index));
+    CHECK(!loaded.load("checkpoint_index_test.missing"));
+    std::remove(INDEX_PATH);
+}
+
+int main()
+{
+    testLiterals();
+
+    TokenGenerator generator(40);
+    auto           data   = generator.text(200000, true);
+    auto           starts = parseSequential(data);
+
+    const uint64_t intervals[][2] { { 100, 0 }, { 0, 4096 }, { 37, 1000 }, { 0, 0 }, { 1, 0 } };
+    for (const auto& interval : intervals) {
+        testSeek(data, starts, interval[0], interval[1], generator);
+    }
+    testSaveLoad(data);
+    return testResult("checkpoint_index_test");
+}
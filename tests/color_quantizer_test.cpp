@@ -0,0 +1,114 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include "ColorQuantizer.h"
+#include "test_support.h"
+
+using namespace ANSI;
+
+using Palette = ColorQuantizer::Palette;
+
+// nearest palette color by comparing the whole palette, the lowest index wins a tie
+static uint8_t nearestReference(const RGB& rgb, int paletteSize)
+{
+    int best     = 0;
+    int bestDist = -1;
+    for (int i = 0; i < paletteSize; ++i) {
+        auto color = ColorTable::bit8Color(uint8_t(i));
+        int  r     = rgb.r - color.r;
+        int  g     = rgb.g - color.g;
+        int  b     = rgb.b - color.b;
+        int  dist  = r * r + g * g + b * b;
+        if (bestDist < 0 || dist < bestDist) {
+            best     = i;
+            bestDist = dist;
+        }
+    }
+    return uint8_t(best);
+}
+
+static void testLiterals()
+{
+    // color 0 is { 1, 1, 1 }, the black of the color cube is exact
+    CHECK(ColorQuantizer::nearest({ 0, 0, 0 }, Palette::COLOR_256) == 16);
+    CHECK(ColorQuantizer::nearest({ 1, 1, 1 }, Palette::COLOR_256) == 0);
+    CHECK(ColorQuantizer::nearest({ 0, 0, 95 }, Palette::COLOR_256) == 17);
+    CHECK(ColorQuantizer::nearest({ 95, 135, 175 }, Palette::COLOR_256) == 67);
+    CHECK(ColorQuantizer::nearest({ 8, 8, 8 }, Palette::COLOR_256) == 232);
+    CHECK(ColorQuantizer::nearest({ 222, 56, 43 }, Palette::COLOR_16) == 1);
+
+    ColorfulText text { "ab", {} };
+    text.color.push_back({ { { 95, 135, 170 }, { 2, 2, 2 } }, 0, 1 });
+    text.color.push_back({ { { 0, 0, 90 }, { 0, 0, 0 } }, 1, 1 });
+    ColorQuantizer::quantize(text, Palette::COLOR_256);
+    CHECK(text.color[0].color.front == ColorTable::bit8Color(67));
+    CHECK(text.color[0].color.back == ColorTable::bit8Color(0));
+    CHECK(text.color[1].color.front == ColorTable::bit8Color(17));
+    CHECK(text.color[1].color.back == ColorTable::bit8Color(16));
+
+    // every palette color maps to itself or to a lower index with the same color
+    for (int i = 0; i < 256; ++i) {
+        auto color = ColorTable::bit8Color(uint8_t(i));
+        auto index = ColorQuantizer::nearest(color, Palette::COLOR_256);
+        CHECK(index <= i && ColorTable::bit8Color(index) == color);
+    }
+}
+
+// every color of the 16 color palette
+static void testExhaustive16()
+{
+    for (int r = 0; r < 256; ++r) {
+        for (int g = 0; g < 256; ++g) {
+            for (int b = 0; b < 256; ++b) {
+                RGB rgb { uint8_t(r), uint8_t(g), uint8_t(b) };
+                CHECK(ColorQuantizer::nearest(rgb, Palette::COLOR_16) == nearestReference(rgb, 16));
+            }
+        }
+    }
+}
+
+/*
+ * Colors of the 256 color palette with channel values at both edges and inside of every lookup cell, the
+ * candidates of a cell are found from its edges. The batch lookup gives the same indexes.
+ */
+static void testSampled256()
+{
+    std::vector<uint8_t> values;
+    for (int value = 0; value < 256; ++value) {
+        if (value % 8 == 0 || value % 8 == 3 || value % 8 == 4 || value % 8 == 7) {
+            values.push_back(uint8_t(value));
+        }
+    }
+
+    std::vector<RGB>     colors;
+    std::vector<uint8_t> indexes(values.size());
+    for (auto r : values) {
+        for (auto g : values) {
+            colors.clear();
+            for (auto b : values) {
+                colors.push_back({ r, g, b });
+                auto expect = nearestReference(colors.back(), 256);
+                CHECK(ColorQuantizer::nearest(colors.back(), Palette::COLOR_256) == expect);
+            }
+            ColorQuantizer::nearest(colors.data(), indexes.data(), colors.size(), Palette::COLOR_256);
+            for (size_t i = 0; i < colors.size(); ++i) {
+                CHECK(indexes[i] == nearestReference(colors[i], 256));
+            }
+        }
+    }
+
+    TokenGenerator generator(81);
+    for (int i = 0; i < 200000; ++i) {
+        RGB rgb { uint8_t(generator.uniform(256)), uint8_t(generator.uniform(256)), uint8_t(generator.uniform(256)) };
+        CHECK(ColorQuantizer::nearest(rgb, Palette::COLOR_256) == nearestReference(rgb, 256));
+    }
+}
+
+int main()
+{
+    testLiterals();
+    testExhaustive16();
+    testSampled256();
+    return testResult("color_quantizer_test");
+}
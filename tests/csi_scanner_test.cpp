@@ -0,0 +1,103 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include "CSIScanner.h"
+#include "test_support.h"
+
+using namespace ANSI;
+
+static const RGB RED { 222, 56, 43 };
+
+static void testMatch()
+{
+    CHECK(CSIScanner::match("\033[31mfoo") == 5);
+    CHECK(CSIScanner::match("\033[1 q") == 5);
+    CHECK(CSIScanner::match("\033[31") == 0);
+    CHECK(CSIScanner::match("\033[3\001m") == 0);
+    CHECK(CSIScanner::match("\033]0;t\007") == 0);
+
+    CHECK(CSIScanner::matchOSC("\033]0;title\007rest") == 10);
+    CHECK(CSIScanner::matchOSC("\033]8;;http://a.b\033\\rest") == 17);
+    CHECK(CSIScanner::matchOSC("\033]0;title") == 0);
+    CHECK(CSIScanner::matchOSC("\033]0;title\033") == 0);
+    CHECK(CSIScanner::matchOSC("\033]0;title\033[31m") == 0);
+    CHECK(CSIScanner::matchOSC("\033]0;ti\ntle\007") == 0);
+
+    CHECK(CSIScanner::matchControl("\033[31m") == 5);
+    CHECK(CSIScanner::matchControl("\033]0;t\007") == 6);
+    CHECK(CSIScanner::matchControl("\033x") == 0);
+
+    // an OSC of MAX_OSC_LEN bytes is matched, a longer one is not
+    std::string longest = "\033]0;" + std::string(CSIScanner::MAX_OSC_LEN - 5, 'x') + "\007";
+    CHECK(CSIScanner::matchOSC(longest) == CSIScanner::MAX_OSC_LEN);
+    CHECK(CSIScanner::matchOSC("\033]0;x" + longest.substr(4)) == 0);
+}
+
+static void testIncompleteLen()
+{
+    CHECK(CSIScanner::incompleteLen("abc") == 0);
+    CHECK(CSIScanner::incompleteLen("abc\033") == 1);
+    CHECK(CSIScanner::incompleteLen("abc\033[31") == 4);
+    CHECK(CSIScanner::incompleteLen("abc\033[31m") == 0);
+    CHECK(CSIScanner::incompleteLen("abc\033[3\001") == 0);
+    CHECK(CSIScanner::incompleteLen("abc\033]0;title") == 9);
+    CHECK(CSIScanner::incompleteLen("abc\033]0;title\033") == 10);
+    CHECK(CSIScanner::incompleteLen("abc\033]0;title\007") == 0);
+    CHECK(CSIScanner::incompleteLen("abc\033]0;ti\ntle") == 0);
+    CHECK(CSIScanner::incompleteLen("abc\033]0;t\033x") == 0);
+    CHECK(CSIScanner::incompleteLen("abc\033]0;t\033[3") == 3);
+
+    // bytes which can not be completed within the limit are text already
+    CHECK(CSIScanner::incompleteLen("\033[" + std::string(CSIScanner::MAX_SEQUENCE_LEN - 3, '0')) == 127);
+    CHECK(CSIScanner::incompleteLen("\033[" + std::string(CSIScanner::MAX_SEQUENCE_LEN - 2, '0')) == 0);
+    CHECK(CSIScanner::incompleteLen("\033]" + std::string(CSIScanner::MAX_OSC_LEN - 2, 'x')) == 0);
+}
+
+static void testScan()
+{
+    std::string text;
+    auto        seqs = CSIScanner::scan("a\033]0;title\007b\033[31mc\033]0;\033[32md", text);
+    CHECK(text == "abc\033]0;d");
+    CHECK(seqs.size() == 3);
+    CHECK(seqs.size() == 3 && seqs[0].pos == 1 && seqs[0].sequence == "\033]0;title\007");
+    CHECK(seqs.size() == 3 && seqs[1].pos == 2 && seqs[1].sequence == "\033[31m");
+    CHECK(seqs.size() == 3 && seqs[2].pos == 7 && seqs[2].sequence == "\033[32m");
+
+    // the OSC does not change the attribute of the text after it
+    TextParser parser(defaultAttr, defaultAttr);
+    auto       result = parser.parse("\033]0;title\007\033[31mred\033]0;x\007red");
+    CHECK(result.text == "redred");
+    CHECK(result.color.size() == 1 && result.color[0].start == 0 && result.color[0].len == 6);
+    CHECK(result.color.size() == 1 && result.color[0].color.front == RED);
+}
+
+// strip, scan and parse remove the same sequences
+static void testStrip()
+{
+    TokenGenerator generator(71);
+    for (int round = 0; round < 2000; ++round) {
+        auto        source = generator.text(generator.uniform(40), true);
+        TextParser  parser(defaultAttr, defaultAttr);
+        auto        expect = parser.parse(source).text;
+        std::string stripped;
+        CSIScanner::strip(source, stripped);
+        CHECK(stripped == expect);
+
+        std::string scanned;
+        CSIScanner::scan(source, scanned);
+        CHECK(scanned == expect);
+
+        CSIScanner::strip(source);
+        CHECK(source == expect);
+    }
+}
+
+int main()
+{
+    testMatch();
+    testIncompleteLen();
+    testScan();
+    testStrip();
+    return testResult("csi_scanner_test");
+}
@@ -0,0 +1,87 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include "HTMLRenderer.h"
+#include "test_support.h"
+
+using namespace ANSI;
+
+static const std::string RED_SPAN = "<span style=\"color:#de382b;background-color:#ffffff\">";
+
+static std::string render(std::string_view data)
+{
+    HTMLRenderer renderer(defaultAttr, defaultAttr);
+    std::string  out;
+    renderer.render(data, out);
+    renderer.finish(out);
+    return out;
+}
+
+static void testEscape()
+{
+    std::string out;
+    HTMLRenderer::escape("a&b<c>d\"e'f", out);
+    CHECK(out == "a&amp;b&lt;c&gt;d&quot;e&#39;f");
+
+    out.clear();
+    HTMLRenderer::escape("0123456789abcdef0123456789abcdef<>", out);
+    CHECK(out == "0123456789abcdef0123456789abcdef&lt;&gt;");
+
+    CHECK(render("<b>&amp;</b>") == "&lt;b&gt;&amp;amp;&lt;/b&gt;");
+    CHECK(render("\033[31m'\"") == RED_SPAN + "&#39;&quot;</span>");
+}
+
+static void testSpans()
+{
+    // sequences which do not change the attribute do not split the span
+    CHECK(render("\033[31mab\033[31mcd\033[0me") == RED_SPAN + "abcd</span>e");
+    CHECK(render("\033[31ma\033[Kb\033[mc") == RED_SPAN + "ab</span>c");
+    CHECK(render("\033[31m\033[32m\033[31ma") == RED_SPAN + "a</span>");
+    CHECK(render("a\033[42mb") == "a<span style=\"color:#000000;background-color:#39b54a\">b</span>");
+    CHECK(render("plain\033[1m") == "plain");
+}
+
+// control bytes and the ESC of sequences which are not valid are not copied into the HTML
+static void testControlBytes()
+{
+    CHECK(render("a\tb\nc\r\n") == "a\tb\nc\r\n");
+    CHECK(render("a\007b\010c\x7F" "d\001") == "abcd");
+    CHECK(render("x\033y\033[2Kz") == "xyz");
+    CHECK(render("a\033[3") == "a[3");
+    CHECK(render("\033]0;title\007\033[31mred\033[m plain") == RED_SPAN + "red</span> plain");
+
+    auto html = render("\033[31mred\033\033[0m\033");
+    CHECK(html == RED_SPAN + "red</span>");
+    CHECK(html.find('\033') == std::string::npos);
+}
+
+// the HTML does not depend on where the stream is split
+static void testChunks()
+{
+    TokenGenerator generator(61);
+    for (int round = 0; round < 300; ++round) {
+        auto data   = generator.text(60, true) + "<&\"'\007";
+        auto expect = render(data);
+
+        HTMLRenderer renderer(defaultAttr, defaultAttr);
+        std::string  out;
+        for (size_t pos = 0; pos < data.size();) {
+            size_t len = std::min(data.size() - pos, 1 + generator.uniform(round % 2 == 0 ? 3 : 40));
+            renderer.render(std::string_view { data }.substr(pos, len), out);
+            pos += len;
+        }
+        renderer.finish(out);
+        CHECK(out == expect);
+        CHECK(out.find('\033') == std::string::npos);
+    }
+}
+
+int main()
+{
+    testEscape();
+    testSpans();
+    testControlBytes();
+    testChunks();
+    return testResult("html_renderer_test");
+}
@@ -0,0 +1,123 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include "CSIScanner.h"
+#include "IncrementalDocument.h"
+#include "test_support.h"
+
+using namespace ANSI;
+
+static const RGB RED { 222, 56, 43 };
+
+static void testLiterals()
+{
+    IncrementalDocument document(defaultAttr, defaultAttr);
+
+    // a sequence cut by the append is not shown until it is complete
+    auto change = document.append("\033[31mred\nplain\033[3");
+    CHECK(change.firstLine == 0 && change.lineCnt == 2);
+    CHECK(document.size() == 2 && document.hasPartialLine());
+    CHECK(document[0].text == "red" && document[0].colorCnt == 1 && document[0].color[0].color.front == RED);
+    CHECK(document[1].text == "plain");
+
+    change = document.append("9mdefault\n");
+    CHECK(change.firstLine == 1 && change.lineCnt == 1);
+    CHECK(document.size() == 2 && !document.hasPartialLine());
+    CHECK(document[1].text == "plaindefault" && document[1].colorCnt == 2);
+    CHECK(document[1].colorCnt == 2 && document[1].color[1].start == 5 && document[1].color[1].color.front == RGB {});
+
+    // so is an OSC which is not terminated yet, a tail which can not become a sequence is shown
+    document.append("a\033]0;tit");
+    CHECK(document.size() == 3 && document[2].text == "a");
+    document.append("le\007b\033x");
+    CHECK(document.size() == 3 && document[2].text == "ab\033x");
+
+    document.clear();
+    CHECK(document.empty());
+    CHECK(document.currentTextAttr().color.front == RGB {});
+}
+
+/*
+ * All lines of data parsed at once. The last line without '\n' is parsed without a tail which can still become
+ * a sequence, IncrementalDocument does not show such a tail until it is complete.
+ */
+static std::vector<ColorfulText> parseWhole(std::string_view data, TextParser::Mode mode)
+{
+    std::vector<ColorfulText> lines;
+    TextParser                parser(defaultAttr, defaultAttr);
+    size_t                    pos = 0;
+    for (auto lineEnd = data.find('\n'); lineEnd != std::string_view::npos; lineEnd = data.find('\n', pos)) {
+        lines.push_back(parser.parse(data.substr(pos, lineEnd - pos), mode));
+        pos = lineEnd + 1;
+    }
+
+    auto partial = data.substr(pos);
+    if (partial.empty()) {
+        return lines;
+    }
+    // the tail is hidden if a terminator or a final byte would complete it
+    size_t hidden = 0;
+    auto   osc    = partial.rfind("\033]");
+    if (osc != std::string_view::npos) {
+        std::string tail(partial.substr(osc));
+        if (CSIScanner::matchOSC(tail + "\007") == tail.size() + 1
+            || CSIScanner::matchOSC(tail + "\\") == tail.size() + 1) {
+            hidden = tail.size();
+        }
+    }
+    auto esc = partial.rfind('\033');
+    if (hidden == 0 && esc != std::string_view::npos) {
+        std::string tail(partial.substr(esc));
+        if (tail == "\033" || CSIScanner::match(tail + "m") == tail.size() + 1) {
+            hidden = tail.size();
+        }
+    }
+    TextParser partialParser(defaultAttr, parser.currentTextAttr());
+    lines.push_back(partialParser.parse(partial.substr(0, partial.size() - hidden), mode));
+    return lines;
+}
+
+static void testAppend(TextParser::Mode mode, uint32_t seed)
+{
+    TokenGenerator      generator(seed);
+    auto                data = generator.text(3000, true);
+    IncrementalDocument document(defaultAttr, defaultAttr, mode);
+
+    std::vector<ColorfulText> before;
+    size_t                    pos = 0;
+    while (pos < data.size()) {
+        size_t size   = std::min(generator.uniform(generator.uniform(3) != 0 ? 8 : 200), data.size() - pos);
+        auto   change = document.append(std::string_view(data).substr(pos, size));
+        pos += size;
+
+        auto expect = parseWhole(std::string_view(data).substr(0, pos), mode);
+        CHECK(document.size() == expect.size());
+        if (document.size() != expect.size()) {
+            continue;
+        }
+        for (size_t i = 0; i < expect.size(); ++i) {
+            CHECK(sameRuns(document[i], expect[i]));
+        }
+
+        // lines after the change are new, lines before it are not changed
+        CHECK(size == 0 ? change.lineCnt == 0 : change.firstLine + change.lineCnt == document.size());
+        for (size_t i = 0; i < change.firstLine && i < before.size(); ++i) {
+            CHECK(sameRuns(document[i], before[i]));
+        }
+        before = std::move(expect);
+    }
+}
+
+int main()
+{
+    testLiterals();
+
+    uint32_t seed = 60;
+    for (auto mode : { TextParser::Mode::ALL_TEXT, TextParser::Mode::MARKED_TEXT }) {
+        for (int i = 0; i < 10; ++i) {
+            testAppend(mode, seed++);
+        }
+    }
+    return testResult("incremental_document_test");
+}
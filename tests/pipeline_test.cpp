@@ -0,0 +1,185 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <thread>
+
+#include "SGRPipeline.h"
+#include "SPSCQueue.h"
+#include "test_support.h"
+
+using namespace ANSI;
+
+// CPU time of the process in seconds, a blocked thread does not add to it
+static double cpuSeconds()
+{
+    return double(std::clock()) / CLOCKS_PER_SEC;
+}
+
+static void testQueue()
+{
+    SPSCQueue<int> queue(5);
+    CHECK(queue.capacity() == 8);
+
+    int value = 0;
+    CHECK(!queue.tryPop(value));
+    for (int i = 0; i < 8; ++i) {
+        CHECK(queue.tryPush(i));
+    }
+    CHECK(!queue.tryPush(8));
+    CHECK(queue.size() == 8);
+    for (int i = 0; i < 8; ++i) {
+        CHECK(queue.tryPop(value) && value == i);
+    }
+    CHECK(!queue.tryPop(value));
+    CHECK(queue.size() == 0);
+}
+
+// every item arrives once and in order, both sides block when they have to wait
+static void testQueueThreads()
+{
+    constexpr int  itemCnt = 200000;
+    SPSCQueue<int> queue(64);
+    std::thread    producer([&queue] {
+        for (int i = 0; i < itemCnt; ++i) {
+            while (!queue.tryPush(i)) {
+                queue.waitNotFull();
+            }
+        }
+    });
+
+    int  value   = 0;
+    bool inOrder = true;
+    for (int i = 0; i < itemCnt; ++i) {
+        while (!queue.tryPop(value)) {
+            queue.waitNotEmpty();
+        }
+        inOrder = inOrder && value == i;
+    }
+    producer.join();
+    CHECK(inOrder);
+    CHECK(queue.size() == 0);
+}
+
+// a consumer waiting for a slow producer sleeps instead of using a core
+static void testQueueBlocks()
+{
+    SPSCQueue<int> queue(4);
+    auto           cpuBegin = cpuSeconds();
+    auto           begin    = std::chrono::steady_clock::now();
+    std::thread    producer([&queue] {
+        for (int i = 0; i < 3; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            queue.tryPush(i);
+        }
+    });
+
+    int value = 0;
+    for (int i = 0; i < 3; ++i) {
+        while (!queue.tryPop(value)) {
+            queue.waitNotEmpty();
+        }
+        CHECK(value == i);
+    }
+    producer.join();
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - begin;
+    CHECK(wall.count() >= 0.3);
+    CHECK(cpuSeconds() - cpuBegin < 0.1);
+}
+
+struct Collected {
+    std::string        text;
+    std::vector<Color> colors; // color of every byte
+    uint64_t           nextSequence = 0;
+    bool               inOrder      = true;
+};
+
+static void collect(const SGRPipeline::RunBatch& batch, Collected& collected)
+{
+    collected.inOrder = collected.inOrder && batch.sequence == collected.nextSequence++;
+    size_t covered    = 0;
+    for (const auto& run : batch.runs) {
+        collected.inOrder = collected.inOrder && run.start == covered;
+        collected.colors.insert(collected.colors.end(), run.len, run.attr.color);
+        covered += run.len;
+    }
+    collected.inOrder = collected.inOrder && covered == batch.text.size();
+    collected.text += batch.text;
+}
+
+// the same text and colors as one TextParser::parse of the whole stream, for any block size
+static void testPipeline()
+{
+    TokenGenerator generator(91);
+    auto           data = generator.text(20000, true);
+
+    TextParser         parser(defaultAttr, defaultAttr);
+    auto               expect = parser.parse(data);
+    std::vector<Color> expectColors(expect.text.size(), defaultAttr.color);
+    for (const auto& run : expect.color) {
+        std::fill_n(expectColors.begin() + run.start, run.len, run.color);
+    }
+
+    for (size_t blockSize : { 1, 7, 4096, 65536 }) {
+        SGRPipeline pipeline(defaultAttr, defaultAttr, { blockSize, 4 });
+        size_t      pos    = 0;
+        auto        reader = [&](char* buf, size_t size) {
+            // short reads like a pipe
+            size_t len = std::min({ size, data.size() - pos, 1 + generator.uniform(size) });
+            std::memcpy(buf, data.data() + pos, len);
+            pos += len;
+            return len;
+        };
+
+        Collected collected;
+        auto      consumer = [&collected](const SGRPipeline::RunBatch& batch) { collect(batch, collected); };
+        auto      metrics  = pipeline.run(reader, consumer);
+        CHECK(collected.inOrder);
+        CHECK(collected.text == expect.text);
+        CHECK(collected.colors == expectColors);
+        CHECK(metrics.bytes == data.size());
+        CHECK(metrics.batches == collected.nextSequence);
+        CHECK(pipeline.currentTextAttr() == parser.currentTextAttr());
+    }
+}
+
+// a reader which waits for data leaves the parser and the consumer blocked, not spinning
+static void testIdleReader()
+{
+    const std::string line   = "\033[31mred\033[m plain\n";
+    int               reads  = 0;
+    auto              reader = [&](char* buf, size_t size) -> size_t {
+        if (reads++ == 5) {
+            return 0;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        size_t len = std::min(size, line.size());
+        std::memcpy(buf, line.data(), len);
+        return len;
+    };
+
+    SGRPipeline pipeline(defaultAttr, defaultAttr, {});
+    Collected   collected;
+    auto        cpuBegin = cpuSeconds();
+    auto        metrics  = pipeline.run(reader, [&](const SGRPipeline::RunBatch& batch) { collect(batch, collected); });
+    auto        cpu      = cpuSeconds() - cpuBegin;
+
+    CHECK(collected.text == "red plain\nred plain\nred plain\nred plain\nred plain\n");
+    CHECK(metrics.seconds >= 0.5);
+    CHECK(metrics.blockQueue.starves > 0 && metrics.blockQueue.starveTime > std::chrono::milliseconds(300));
+    CHECK(metrics.batchQueue.starves > 0 && metrics.batchQueue.starveTime > std::chrono::milliseconds(300));
+    CHECK(cpu < 0.1);
+}
+
+int main()
+{
+    testQueue();
+    testQueueThreads();
+    testQueueBlocks();
+    testPipeline();
+    testIdleReader();
+    return testResult("pipeline_test");
+}
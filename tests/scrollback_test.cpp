@@ -0,0 +1,108 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include <deque>
+
+#include "AttributeTable.h"
+#include "Scrollback.h"
+#include "test_support.h"
+
+using namespace ANSI;
+
+static_assert(sizeof(PackedRun) == 12, "a run takes 12 bytes of the arena");
+
+static const RGB RED { 222, 56, 43 };
+
+static void testLiterals()
+{
+    Scrollback scrollback(defaultAttr, defaultAttr, 2, 64);
+    CHECK(scrollback.append("\033[31mred\033[0m plain"));
+    CHECK(scrollback.size() == 1 && scrollback.usedBytes() == 36);
+    auto line = scrollback[0];
+    CHECK(line.text == "red plain" && line.runCnt == 2);
+    if (line.runCnt == 2) {
+        auto run = *line.begin();
+        CHECK(run.start == 0 && run.len == 3 && run.attr.color.front == RED);
+        run = *++line.begin();
+        CHECK(run.start == 3 && run.len == 6 && run.attr == defaultAttr);
+    }
+
+    // the oldest line is evicted when maxLines is reached
+    CHECK(scrollback.append("a"));
+    CHECK(scrollback.append("b"));
+    CHECK(scrollback.size() == 2 && scrollback[0].text == "a" && scrollback[1].text == "b");
+    CHECK(scrollback.usedBytes() <= scrollback.maxBytes());
+
+    // a line larger than the arena is not stored, its attribute is kept
+    CHECK(!scrollback.append("\033[31m" + std::string(100, 'x')));
+    CHECK(scrollback.size() == 2 && scrollback.currentTextAttr().color.front == RED);
+    CHECK(scrollback.append("c"));
+    CHECK(scrollback[1].text == "c" && scrollback[1].runCnt == 1 && (*scrollback[1].begin()).attr.color.front == RED);
+}
+
+// the lines kept are the last ones which fit, with the runs of TextParser::parse
+static void testAppend(size_t maxLines, size_t maxBytes, uint32_t seed)
+{
+    TokenGenerator generator(seed);
+    Scrollback     scrollback(defaultAttr, defaultAttr, maxLines, maxBytes);
+    TextParser     parser(defaultAttr, defaultAttr);
+    AttributeTable table;
+
+    std::deque<CompactText> expect;
+    for (int i = 0; i < 50000; ++i) {
+        auto line = generator.text(generator.uniform(generator.uniform(7) == 0 ? 40 : 6), false);
+        auto text = parser.parse(line, table);
+
+        size_t need     = (text.runs.size() * sizeof(PackedRun) + text.text.size() + 3) / 4 * 4;
+        bool   appended = scrollback.append(line);
+        CHECK(appended == (need <= scrollback.maxBytes()));
+        CHECK(scrollback.currentTextAttr() == parser.currentTextAttr());
+        if (!appended) {
+            continue;
+        }
+
+        expect.push_back(std::move(text));
+        while (expect.size() > scrollback.size()) {
+            expect.pop_front();
+        }
+        CHECK(expect.size() == scrollback.size());
+        CHECK(scrollback.size() <= scrollback.maxLines());
+        CHECK(scrollback.usedBytes() <= scrollback.maxBytes());
+        if (i % 97 != 0 || expect.size() != scrollback.size()) {
+            continue;
+        }
+
+        for (size_t k = 0; k < scrollback.size(); ++k) {
+            auto        line = scrollback[k];
+            const auto& text = expect[k];
+            CHECK(line.text == text.text);
+            CHECK(line.runCnt == text.runs.size());
+            if (line.runCnt != text.runs.size()) {
+                continue;
+            }
+            size_t r = 0;
+            for (auto run : line) {
+                const auto& expectRun = text.runs[r++];
+                CHECK(run.start == expectRun.start && run.len == expectRun.len);
+                CHECK(run.attr == table.resolve(expectRun.attrId));
+            }
+        }
+    }
+
+    scrollback.clear();
+    CHECK(scrollback.empty() && scrollback.usedBytes() == 0);
+    CHECK(scrollback.currentTextAttr() == parser.currentTextAttr());
+}
+
+int main()
+{
+    testLiterals();
+
+    const size_t limits[][2] { { 100000, 256 }, { 50, 256 }, { 100000, 3001 }, { 50, 3001 }, { 1000, 1 << 20 } };
+    uint32_t     seed = 50;
+    for (const auto& limit : limits) {
+        testAppend(limit[0], limit[1], seed++);
+    }
+    return testResult("scrollback_test");
+}
@@ -0,0 +1,100 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include "SGRCache.h"
+#include "test_support.h"
+
+using namespace ANSI;
+
+static const RGB RED { 222, 56, 43 };
+
+static bool sameTransform(const TextAttributeTransform& a, const TextAttributeTransform& b)
+{
+    return a.mask == b.mask && a.apply(defaultAttr) == b.apply(defaultAttr);
+}
+
+static void testCache()
+{
+    SGRCache                      cache;
+    SGRParser                     parser(defaultAttr);
+    SGRParser::SGRTransformReturn result;
+    auto                          red = parser.parseSGRTransform("31");
+
+    CHECK(!cache.find("31", result));
+    CHECK(cache.hits() == 0 && cache.misses() == 1);
+    cache.insert("31", red);
+    CHECK(cache.find("31", result));
+    CHECK(cache.hits() == 1 && cache.misses() == 1);
+    CHECK(sameTransform(result.second, red.second));
+    CHECK(result.second.apply(defaultAttr).color.front == RED);
+
+    // a key of the same length but other bytes is a miss
+    CHECK(!cache.find("32", result));
+    CHECK(cache.hits() == 1 && cache.misses() == 2);
+
+    // MAX_KEY_LEN bytes are cached, a longer key never is
+    std::string longest(SGRCache::MAX_KEY_LEN, '0');
+    std::string tooLong(SGRCache::MAX_KEY_LEN + 1, '0');
+    cache.insert(longest, red);
+    CHECK(cache.find(longest, result));
+    cache.insert(tooLong, red);
+    CHECK(!cache.find(tooLong, result));
+    CHECK(cache.hits() == 2 && cache.misses() == 3);
+
+    cache.clear();
+    CHECK(cache.hits() == 0 && cache.misses() == 0);
+    CHECK(!cache.find("31", result));
+}
+
+static void testParserCounts()
+{
+    SGRParser parser(defaultAttr);
+    CHECK(parser.cache() == nullptr);
+    parser.enableCache(true);
+    CHECK(parser.cache() != nullptr);
+
+    auto first  = parser.parseSGRTransform("1;31");
+    auto second = parser.parseSGRTransform("1;31");
+    CHECK(parser.cache()->misses() == 1 && parser.cache()->hits() == 1);
+    CHECK(first.first == second.first && sameTransform(first.second, second.second));
+
+    std::string tooLong = "31";
+    while (tooLong.size() <= SGRCache::MAX_KEY_LEN) {
+        tooLong += ";0";
+    }
+    first  = parser.parseSGRTransform(tooLong);
+    second = parser.parseSGRTransform(tooLong);
+    CHECK(parser.cache()->misses() == 3 && parser.cache()->hits() == 1);
+    CHECK(sameTransform(first.second, second.second));
+    CHECK(first.second.apply(defaultAttr) == defaultAttr);
+
+    parser.enableCache(false);
+    CHECK(parser.cache() == nullptr);
+}
+
+// every parameter of the generated text, parsed with and without the cache
+static void testCachedParse()
+{
+    TokenGenerator generator(41);
+    auto           lines = generator.lines(5000, 10);
+
+    TextParser cached(defaultAttr, defaultAttr);
+    TextParser uncached(defaultAttr, defaultAttr);
+    cached.sgrParser().enableCache(true);
+    for (const auto& line : lines) {
+        auto expect = uncached.parse(line);
+        auto result = cached.parse(line);
+        CHECK(sameRuns({ result.text, result.color.data(), result.color.size() }, expect));
+    }
+    CHECK(cached.currentTextAttr() == uncached.currentTextAttr());
+    CHECK(cached.sgrParser().cache()->hits() > 0);
+}
+
+int main()
+{
+    testCache();
+    testParserCounts();
+    testCachedParse();
+    return testResult("sgr_cache_test");
+}
@@ -0,0 +1,134 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include "AttributeTable.h"
+#include "SGREncoder.h"
+#include "test_support.h"
+
+using namespace ANSI;
+
+/*
+ * A default state with colors which are not the default ones can not be written, SGREncoder writes the colors
+ * with state CUSTOM then.
+ */
+static bool sameWritten(const TextAttribute& attr, const TextAttribute& expect)
+{
+    if (expect.state == TextAttribute::State::CUSTOM || expect.color == defaultAttr.color) {
+        return attr == expect;
+    }
+    return attr.color == expect.color;
+}
+
+// attribute of every byte of the text
+static std::vector<TextAttribute> byteAttrs(const CompactText& text, const AttributeTable& table)
+{
+    std::vector<TextAttribute> attrs(text.text.size(), defaultAttr);
+    for (const auto& run : text.runs) {
+        std::fill_n(attrs.begin() + run.start, run.len, table.resolve(run.attrId));
+    }
+    return attrs;
+}
+
+static void testLiterals()
+{
+    SGRParser parser(defaultAttr);
+    auto      red     = parser.parseSGRSequence(defaultAttr, "\033[31m").second;
+    auto      redBlue = parser.parseSGRSequence(red, "\033[44m").second;
+    auto      rgb     = parser.parseSGRSequence(defaultAttr, "\033[38;2;1;2;3m").second;
+    auto      palette = parser.parseSGRSequence(defaultAttr, "\033[38;5;200m").second;
+
+    SGREncoder encoder(defaultAttr, defaultAttr);
+    auto       transition = [&encoder](const TextAttribute& from, const TextAttribute& to) {
+        std::string sequence;
+        encoder.encodeTransition(from, to, sequence);
+        return sequence;
+    };
+    CHECK(transition(defaultAttr, red) == "\033[31m");
+    CHECK(transition(red, defaultAttr) == "\033[m");
+    CHECK(transition(red, redBlue) == "\033[44m");
+    CHECK(transition(defaultAttr, rgb) == "\033[38;2;1;2;3m");
+    CHECK(transition(defaultAttr, palette) == "\033[38;5;200m");
+    CHECK(transition(red, red).empty());
+
+    // a run with the attribute of the run before it needs no sequence
+    std::string out;
+    encoder.encode("foo", red, out);
+    encoder.encode("bar", red, out);
+    encoder.encode("baz", defaultAttr, out);
+    CHECK(out == "\033[31mfoobar\033[mbaz");
+    CHECK(encoder.currentTextAttr() == defaultAttr);
+}
+
+// parse, encode and parse again gives the same text and attributes
+static void testRoundTrip()
+{
+    TokenGenerator generator(70);
+    auto           lines = generator.lines(20000, 10);
+
+    AttributeTable table;
+    AttributeTable encodedTable;
+    TextParser     parser(defaultAttr, defaultAttr);
+    TextParser     encodedParser(defaultAttr, defaultAttr);
+    SGREncoder     encoder(defaultAttr, defaultAttr);
+    std::string    encoded;
+    for (const auto& line : lines) {
+        auto text = parser.parse(line, table);
+        // ESC left in the text can start a sequence with the bytes after it once the sequence between is gone
+        if (text.text.find('\033') != std::string::npos) {
+            continue;
+        }
+        encoded.clear();
+        encoder.encode(text, table, encoded);
+        auto encodedText = encodedParser.parse(encoded, encodedTable);
+
+        CHECK(encodedText.text == text.text);
+        if (encodedText.text != text.text) {
+            continue;
+        }
+        auto expect = byteAttrs(text, table);
+        auto attrs  = byteAttrs(encodedText, encodedTable);
+        for (size_t i = 0; i < expect.size(); ++i) {
+            CHECK(sameWritten(attrs[i], expect[i]));
+        }
+    }
+}
+
+// the transition between two attributes is parsed back to the second one
+static void testTransition()
+{
+    const RGB colors[] { { 0, 0, 0 },     { 255, 255, 255 }, { 222, 56, 43 },    { 255, 0, 0 },
+                         { 95, 135, 175 }, { 8, 8, 8 },       { 1, 2, 3 },        { 128, 128, 128 },
+                         { 238, 238, 238 }, { 0, 95, 0 } };
+    constexpr size_t colorCnt = sizeof(colors) / sizeof(colors[0]);
+
+    TokenGenerator generator(71);
+    auto           randomAttr = [&] {
+        auto state = generator.uniform(2) == 0 ? TextAttribute::State::DEFAULT : TextAttribute::State::CUSTOM;
+        return TextAttribute { state, { colors[generator.uniform(colorCnt)], colors[generator.uniform(colorCnt)] } };
+    };
+
+    SGRParser  parser(defaultAttr);
+    SGREncoder encoder(defaultAttr, defaultAttr);
+    for (int i = 0; i < 100000; ++i) {
+        auto from = randomAttr();
+        auto to   = randomAttr();
+        if (to.state == TextAttribute::State::DEFAULT) {
+            to.color = defaultAttr.color;
+        }
+
+        std::string sequence;
+        encoder.encodeTransition(from, to, sequence);
+        CHECK(sequence.empty() == (from == to));
+        auto parsed = sequence.empty() ? from : parser.parseSGRSequence(from, sequence).second;
+        CHECK(parsed == to);
+    }
+}
+
+int main()
+{
+    testLiterals();
+    testRoundTrip();
+    testTransition();
+    return testResult("sgr_encoder_test");
+}
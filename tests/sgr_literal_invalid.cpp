@@ -0,0 +1,12 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include "test_support.h"
+
+using namespace ANSI;
+
+// the final byte is not 'm', so this must not compile, the sgr_literal_invalid test builds it and expects failure
+constexpr auto INVALID = sgrLiteral(defaultAttr, defaultAttr, "\033[31K");
+
+int main() { return INVALID == defaultAttr ? 0 : 1; }
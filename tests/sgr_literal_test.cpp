@@ -0,0 +1,51 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include "test_support.h"
+
+using namespace ANSI;
+
+// a constexpr variable must be initialized by a constant expression, so these fail the build if sgrLiteral
+// is not evaluated at compile time
+constexpr auto RED_ATTR  = sgrLiteral(defaultAttr, defaultAttr, "\033[31m");
+constexpr auto BOLD_RGB  = sgrLiteral(defaultAttr, defaultAttr, "\033[1;38;2;95;135;175m");
+constexpr auto RED_ON_BG = sgrLiteral(defaultAttr, RED_ATTR, "\033[48;5;17m");
+constexpr auto RESET     = sgrLiteral(defaultAttr, RED_ON_BG, "\033[m");
+
+static_assert(RED_ATTR.state == TextAttribute::State::CUSTOM, "31 sets a custom attribute");
+static_assert(RED_ATTR.color.front == RGB { 222, 56, 43 }, "31 is the red of the color table");
+static_assert(RED_ATTR.color.back == defaultAttr.color.back, "31 keeps the background");
+static_assert(BOLD_RGB.color.front == RGB { 95, 135, 175 }, "38;2 sets the RGB value");
+static_assert(RED_ON_BG.color.front == RED_ATTR.color.front, "48 keeps the foreground");
+static_assert(RED_ON_BG.color.back == RGB { 0, 0, 95 }, "color 17 of the 256 color cube");
+static_assert(RESET == defaultAttr, "an empty parameter resets");
+
+// the compile time result is the one of the runtime parser
+static void testRuntimeParity()
+{
+    struct Case {
+        TextAttribute    literal;
+        TextAttribute    current;
+        std::string_view sequence;
+    };
+    const Case cases[] {
+        { RED_ATTR, defaultAttr, "\033[31m" },
+        { BOLD_RGB, defaultAttr, "\033[1;38;2;95;135;175m" },
+        { RED_ON_BG, RED_ATTR, "\033[48;5;17m" },
+        { RESET, RED_ON_BG, "\033[m" },
+    };
+
+    SGRParser parser(defaultAttr);
+    for (const auto& test : cases) {
+        auto result = parser.parseSGRSequence(test.current, test.sequence);
+        CHECK(result.first == Return::PARSE_SUCC);
+        CHECK(result.second == test.literal);
+    }
+}
+
+int main()
+{
+    testRuntimeParity();
+    return testResult("sgr_literal_test");
+}
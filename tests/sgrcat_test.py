@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+#
+# Created by marvin on 26-10-17.
+#
+# sgrcat output of every format, for a small literal input and for a generated input of several chunks which is
+# read from a file, from a pipe and with one thread.
+#
+# usage: sgrcat_test.py path/to/sgrcat
+
+import os
+import random
+import re
+import subprocess
+import sys
+import tempfile
+
+ESC = b"\x1b"
+
+# CSI sequence or OSC, longer ones are text
+SEQUENCE = re.compile(rb"\x1b(?:\[[0-?]*[ -/]*[@-~]|\][^\x07\x1b\n]*(?:\x07|\x1b\\))")
+MAX_SEQUENCE_LEN = 128
+MAX_OSC_LEN = 4096
+
+TOKENS = [
+    b"ab", b"cd efghijklmnop ", b"0123456789" * 4, b"<&>\"'", b"\t", b"\x07",
+    b"\x1b[31m", b"\x1b[0m", b"\x1b[m", b"\x1b[1;38;5;200m", b"\x1b[48;2;1;2;3m", b"\x1b[K", b"\x1b[1 q",
+    b"\x1b]0;title\x07", b"\x1b]8;;http://a.b/c\x1b\\", b"\x1b]2;not terminated", b"x\x1by", b"\x1b", b"\x1b[",
+    "中文".encode(), b"\n", b"\n",
+]
+
+failures = 0
+
+
+def check(ok, what):
+    global failures
+    if not ok:
+        failures += 1
+        print("check failed: " + what, file=sys.stderr)
+
+
+def strip(data):
+    def keep_long(match):
+        seq = match.group(0)
+        limit = MAX_OSC_LEN if seq[1:2] == b"]" else MAX_SEQUENCE_LEN
+        return seq if len(seq) > limit else b""
+
+    return SEQUENCE.sub(keep_long, data)
+
+
+def sgrcat(binary, args, data=None, path=None):
+    command = [binary] + args + ([path] if path else [])
+    return subprocess.run(command, input=data, stdout=subprocess.PIPE, check=True).stdout
+
+
+def test_literal(binary):
+    data = b"\x1b]0;title\x07\x1b[31mred\x1b[m plain\n"
+
+    runs = sgrcat(binary, ["--format", "runs"], data).decode().splitlines()
+    check(runs[:1] == ["0 3 custom de382b ffffff"], "red run at offset 0: %r" % runs)
+    check(runs[1:2] == ["3 7 default 000000 ffffff"], "plain run after it: %r" % runs)
+
+    text = sgrcat(binary, ["--format", "text"], data)
+    check(text == b"red plain\n", "text: %r" % text)
+
+    html = sgrcat(binary, ["--format", "html"], data)
+    check(ESC not in html and b"]0;title" not in html and b"\x07" not in html, "html: %r" % html)
+    check(b'<span style="color:#de382b;background-color:#ffffff">red</span> plain' in html, "html: %r" % html)
+
+
+def test_chunks(binary):
+    rng = random.Random(17)
+    data = b"".join(rng.choice(TOKENS) for _ in range(700000))
+    check(len(data) > 3 << 20, "input of several 1 MiB chunks")
+
+    with tempfile.TemporaryDirectory() as directory:
+        path = os.path.join(directory, "input.txt")
+        with open(path, "wb") as file:
+            file.write(data)
+
+        for output_format in ("text", "runs", "html"):
+            # one chunk, so runs and spans are not joined across chunk borders
+            expect = sgrcat(binary, ["--format", output_format, "--chunk", "64", "--threads", "1"], path=path)
+            args = ["--format", output_format, "--chunk", "1"]
+            check(sgrcat(binary, args + ["--threads", "1"], path=path) == expect, output_format + " chunks")
+            check(sgrcat(binary, args + ["--threads", "4"], path=path) == expect, output_format + " mapped file")
+            check(sgrcat(binary, args + ["--threads", "3"], data) == expect, output_format + " pipe")
+            if output_format == "text":
+                check(expect == strip(data), "text is the input without sequences")
+
+
+def main():
+    if len(sys.argv) != 2:
+        print("usage: sgrcat_test.py path/to/sgrcat", file=sys.stderr)
+        return 2
+    test_literal(sys.argv[1])
+    test_chunks(sys.argv[1])
+    if failures:
+        print("sgrcat_test: %d checks failed" % failures, file=sys.stderr)
+        return 1
+    print("sgrcat_test: passed")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,100 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include <cstring>
+
+#include "SIMD.h"
+#include "test_support.h"
+
+using namespace ANSI;
+
+using FindFunc = const char* (*)(const char* begin, const char* end);
+
+static const SIMD::Level LEVELS[] { SIMD::Level::SCALAR, SIMD::Level::SSE2, SIMD::Level::AVX2 };
+
+// first byte of [begin, end) for which isMatch is true, end if none
+template <typename Pred>
+static const char* findReference(const char* begin, const char* end, Pred&& isMatch)
+{
+    while (begin != end && !isMatch(static_cast<uint8_t>(*begin))) {
+        ++begin;
+    }
+    return begin;
+}
+
+static bool isEscape(uint8_t ch)
+{
+    return ch == 0x1B;
+}
+
+static bool isHTMLSpecial(uint8_t ch)
+{
+    if (ch < 0x20) {
+        return ch != '\t' && ch != '\n' && ch != '\r';
+    }
+    return ch == '<' || ch == '>' || ch == '&' || ch == '"' || ch == '\'' || ch == 0x7F;
+}
+
+static bool isNonPrintableASCII(uint8_t ch)
+{
+    return ch < 0x20 || ch > 0x7E;
+}
+
+static void testLiterals()
+{
+    for (auto level : LEVELS) {
+        SIMD::setLevel(level);
+        const char* text = "plain text\033[31m";
+        CHECK(SIMD::findEscape(text, text + std::strlen(text)) == text + 10);
+        CHECK(SIMD::findEscape(text, text + 10) == text + 10);
+        text = "0123456789abcdef0123456789abcdef0123456789<b>";
+        CHECK(SIMD::findHTMLSpecial(text, text + std::strlen(text)) == text + 42);
+        text = "0123456789abcdef\t\n\r\xC3\xA9" "56789abcdef0123456789\033";
+        CHECK(SIMD::findHTMLSpecial(text, text + std::strlen(text)) == text + 42);
+        text = "0123456789abcdef0123456789abcdef0123456789\x7F";
+        CHECK(SIMD::findHTMLSpecial(text, text + std::strlen(text)) == text + 42);
+        text = "0123456789abcdef0123456789abcdef\xE4\xB8\xAD";
+        CHECK(SIMD::findNonPrintableASCII(text, text + std::strlen(text)) == text + 32);
+    }
+    SIMD::setLevel(SIMD::supportedLevel());
+}
+
+/*
+ * Every level finds the byte of the scalar reference, for every length around the 16 and 32 byte blocks and
+ * every alignment of the start, so the block loops and the scalar tails are both covered.
+ */
+template <typename Pred>
+static void testParity(FindFunc find, Pred&& isMatch, uint32_t seed)
+{
+    TokenGenerator generator(seed);
+    std::string    buffer(200, '\0');
+    for (int round = 0; round < 3000; ++round) {
+        // matching bytes are rare, so most searches run over many blocks
+        for (auto& ch : buffer) {
+            ch = char(generator.uniform(64) != 0 ? 0x20 + generator.uniform(95) : generator.uniform(256));
+        }
+        size_t      offset = generator.uniform(33);
+        size_t      len    = generator.uniform(buffer.size() - offset + 1);
+        const char* begin  = buffer.data() + offset;
+        const char* end    = begin + len;
+        const char* expect = findReference(begin, end, isMatch);
+        for (auto level : LEVELS) {
+            SIMD::setLevel(level);
+            CHECK(find(begin, end) == expect);
+        }
+    }
+    SIMD::setLevel(SIMD::supportedLevel());
+}
+
+int main()
+{
+    // a level which the CPU does not support is clamped, so the test runs everywhere
+    std::printf("supported level %d\n", int(SIMD::supportedLevel()));
+
+    testLiterals();
+    testParity(SIMD::findEscape, isEscape, 10);
+    testParity(SIMD::findHTMLSpecial, isHTMLSpecial, 11);
+    testParity(SIMD::findNonPrintableASCII, isNonPrintableASCII, 12);
+    return testResult("simd_test");
+}
@@ -0,0 +1,176 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include <cstring>
+
+#include "SGRStreamParser.h"
+#include "TextParser.h"
+#include "test_support.h"
+
+using namespace ANSI;
+
+// text and color of every byte of the text
+struct ByteColors {
+    std::string        text;
+    std::vector<Color> colors;
+};
+
+static ByteColors parseWhole(std::string_view data)
+{
+    TextParser parser(defaultAttr, defaultAttr);
+    auto       text = parser.parse(data);
+
+    ByteColors result { text.text, std::vector<Color>(text.text.size(), defaultAttr.color) };
+    for (const auto& run : text.color) {
+        std::fill_n(result.colors.begin() + run.start, run.len, run.color);
+    }
+    return result;
+}
+
+static ByteColors parseSplit(std::string_view data, TokenGenerator& generator, size_t maxChunk)
+{
+    ByteColors      result;
+    SGRStreamParser parser(defaultAttr, defaultAttr);
+    auto            onText = [&result](std::string_view text, const TextAttribute& attr) {
+        result.text.append(text.data(), text.size());
+        result.colors.insert(result.colors.end(), text.size(), attr.color);
+    };
+
+    while (!data.empty()) {
+        auto chunk = data.substr(0, 1 + generator.uniform(maxChunk));
+        parser.parse(chunk, onText);
+        data.remove_prefix(chunk.size());
+    }
+    parser.finish(onText);
+    return result;
+}
+
+static bool same(const ByteColors& a, const ByteColors& b)
+{
+    if (a.text != b.text || a.colors.size() != b.colors.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.colors.size(); ++i) {
+        if (a.colors[i] != b.colors[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static ByteColors parseChunks(std::initializer_list<std::string_view> chunks)
+{
+    ByteColors      result;
+    SGRStreamParser parser(defaultAttr, defaultAttr);
+    auto            onText = [&result](std::string_view text, const TextAttribute& attr) {
+        result.text.append(text.data(), text.size());
+        result.colors.insert(result.colors.end(), text.size(), attr.color);
+    };
+    for (auto chunk : chunks) {
+        parser.parse(chunk, onText);
+    }
+    parser.finish(onText);
+    return result;
+}
+
+static void testLiterals()
+{
+    const RGB red { 222, 56, 43 };
+
+    // a sequence cut after "\033[3" is applied when the rest comes
+    auto result = parseChunks({ "\033[3", "1mfoo" });
+    CHECK(result.text == "foo");
+    CHECK(result.colors.size() == 3 && result.colors[0].front == red && result.colors[2].front == red);
+    CHECK(result.colors.size() == 3 && result.colors[0].back == defaultAttr.color.back);
+
+    result = parseChunks({ "a\033", "[", "31;4", "1mb\033[", "0mc" });
+    CHECK(result.text == "abc");
+    CHECK(result.colors.size() == 3 && result.colors[0] == defaultAttr.color);
+    CHECK(result.colors.size() == 3 && result.colors[1].front == red && result.colors[1].back == red);
+    CHECK(result.colors.size() == 3 && result.colors[2] == defaultAttr.color);
+
+    // an invalid byte ends the sequence, its bytes are text
+    result = parseChunks({ "a\033[31", "\001b" });
+    CHECK(result.text == "a\033[31\001b");
+
+    // an unfinished sequence at the end of the stream is text
+    result = parseChunks({ "a\033[3" });
+    CHECK(result.text == "a\033[3");
+
+    // non-SGR sequences are removed without effect
+    result = parseChunks({ "a\033[2", "Kb" });
+    CHECK(result.text == "ab");
+    CHECK(result.colors.size() == 2 && result.colors[1] == defaultAttr.color);
+
+    // OSC are removed wherever they are split, the text after them keeps its attribute
+    result = parseChunks({ "\033[31ma\033]0;ti", "tle\007b\033]8;;x\033", "\\c" });
+    CHECK(result.text == "abc");
+    CHECK(result.colors.size() == 3 && result.colors[2].front == red);
+
+    // an ESC which does not start ST cancels the OSC and starts the next sequence
+    result = parseChunks({ "a\033]0;x\033", "[0mb" });
+    CHECK(result.text == "a\033]0;xb");
+    result = parseChunks({ "a\033]0;x\033" });
+    CHECK(result.text == "a\033]0;x\033");
+    result = parseChunks({ "a\033]0;x\033", "yz" });
+    CHECK(result.text == "a\033]0;x\033yz");
+
+    // a line feed cancels an OSC
+    result = parseChunks({ "a\033]0;x", "\ny\007" });
+    CHECK(result.text == "a\033]0;x\ny\007");
+
+    // an OSC of MAX_OSC_LEN bytes is removed, a longer one is text
+    std::string longestOSC = "\033]0;" + std::string(SGRStreamParser::MAX_OSC_LEN - 5, 'x') + "\007";
+    result                 = parseChunks({ "a", longestOSC.substr(0, 100), longestOSC.substr(100), "b" });
+    CHECK(result.text == "ab");
+    longestOSC.insert(4, "x");
+    result = parseChunks({ "a", longestOSC.substr(0, 100), longestOSC.substr(100), "b" });
+    CHECK(result.text == "a" + longestOSC + "b");
+
+    // a sequence of MAX_SEQUENCE_LEN bytes is removed, a longer one is text
+    std::string longest = "\033[" + std::string(CSIScanner::MAX_SEQUENCE_LEN - 3, '0') + "m";
+    std::string tooLong = "\033[" + std::string(CSIScanner::MAX_SEQUENCE_LEN - 2, '0') + "m";
+    result              = parseChunks({ "a", longest.substr(0, 70), longest.substr(70), "b" });
+    CHECK(result.text == "ab");
+    result = parseChunks({ "a", tooLong.substr(0, 70), tooLong.substr(70), "b" });
+    CHECK(result.text == "a" + tooLong + "b");
+}
+
+// the same result as CSIScanner however the stream is split
+static void testSplit()
+{
+    TokenGenerator generator(30);
+    for (int round = 0; round < 200; ++round) {
+        auto data   = generator.text(300, true);
+        auto expect = parseWhole(data);
+        CHECK(same(parseSplit(data, generator, 1), expect));
+        CHECK(same(parseSplit(data, generator, 40), expect));
+    }
+}
+
+// sequences around MAX_SEQUENCE_LEN are sequences or text in both parsers
+static void testLongSequences()
+{
+    TokenGenerator generator(31);
+    for (int round = 0; round < 200; ++round) {
+        std::string data;
+        for (int i = 0; i < 50; ++i) {
+            data += "ab\033[3" + std::to_string(generator.uniform(8)) + ';';
+            size_t sequenceLen = CSIScanner::MAX_SEQUENCE_LEN - 10 + generator.uniform(20);
+            data.append(sequenceLen - 7, '0');
+            data += "1m";
+        }
+        auto expect = parseWhole(data);
+        CHECK(same(parseSplit(data, generator, 1), expect));
+        CHECK(same(parseSplit(data, generator, 40), expect));
+    }
+}
+
+int main()
+{
+    testLiterals();
+    testSplit();
+    testLongSequences();
+    return testResult("stream_parser_test");
+}
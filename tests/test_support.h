@@ -0,0 +1,128 @@
+//
+// Created by marvin on 26-10-17.
+//
+#pragma once
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "TextParser.h"
+
+namespace ANSI {
+
+static constexpr TextAttribute defaultAttr { TextAttribute::State::DEFAULT, { { 0, 0, 0 }, { 255, 255, 255 } } };
+
+// failed checks of the test program, only the first ones are printed
+inline size_t& checkFailures()
+{
+    static size_t failures = 0;
+    return failures;
+}
+
+inline void checkFailed(const char* file, int line, const char* expr)
+{
+    if (checkFailures()++ < 20) {
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+    }
+}
+
+#define CHECK(expr)                                 \
+    do {                                            \
+        if (!(expr)) {                              \
+            checkFailed(__FILE__, __LINE__, #expr); \
+        }                                           \
+    } while (false)
+
+// exit code of main
+inline int testResult(const char* name)
+{
+    if (checkFailures() != 0) {
+        std::fprintf(stderr, "%s: %zu checks failed\n", name, checkFailures());
+        return 1;
+    }
+    std::printf("%s: passed\n", name);
+    return 0;
+}
+
+/*
+ * Random text of tokens: plain text, SGR sequences of every color kind, other CSI sequences, OSC, sequences
+ * which are not complete or not valid, UTF-8 and line feeds. The seed makes a failure reproducible.
+ */
+class TokenGenerator {
+public:
+    explicit TokenGenerator(uint32_t seed)
+        : rng_(seed)
+    {
+    }
+
+    std::string text(size_t tokenCnt, bool lineFeeds)
+    {
+        static const char* const tokens[] {
+            "ab",
+            "cd efghijklmnop ",
+            "0123456789012345678901234567890123456789",
+            "\033[31m",
+            "\033[0m",
+            "\033[m",
+            "\033[39m",
+            "\033[42m",
+            "\033[1;38;5;200m",
+            "\033[2;38;2;1;2;3m",
+            "\033[48;5;17;97m",
+            "\033[K",
+            "\033[1 q",
+            "x\033y",
+            "\033",
+            "\033[",
+            "\033]0;title\007",
+            "\033]8;;http://a.b/c\033\\",
+            "\033]2;not terminated",
+            "\033]0;\033",
+            "\xE4\xB8\xAD\xE6\x96\x87",
+            "e\xCC\x81",
+            "\n",
+        };
+        constexpr size_t tokenKinds = sizeof(tokens) / sizeof(tokens[0]);
+
+        std::string result;
+        for (size_t i = 0; i < tokenCnt; ++i) {
+            size_t kind = uniform(lineFeeds ? tokenKinds : tokenKinds - 1);
+            result += tokens[kind];
+        }
+        return result;
+    }
+
+    std::vector<std::string> lines(size_t lineCnt, size_t maxTokens)
+    {
+        std::vector<std::string> result(lineCnt);
+        for (auto& line : result) {
+            line = text(uniform(maxTokens + 1), false);
+        }
+        return result;
+    }
+
+    // 0 <= result < bound
+    inline size_t uniform(size_t bound) { return std::uniform_int_distribution<size_t>(0, bound - 1)(rng_); }
+
+private:
+    std::mt19937 rng_;
+};
+
+inline bool sameRuns(const ColorfulTextView& view, const ColorfulText& text)
+{
+    if (view.text != text.text || view.colorCnt != text.color.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < view.colorCnt; ++i) {
+        const auto& a = view.color[i];
+        const auto& b = text.color[i];
+        if (a.color != b.color || a.start != b.start || a.len != b.len) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace ANSI
@@ -0,0 +1,229 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include <memory_resource>
+
+#include "AttributeTable.h"
+#include "TextParser.h"
+#include "test_support.h"
+
+using namespace ANSI;
+
+static const RGB RED { 222, 56, 43 };
+
+static void testLiterals()
+{
+    TextParser parser(defaultAttr, defaultAttr);
+    auto       result = parser.parse("\033[31mfoo");
+    CHECK(result.text == "foo");
+    CHECK(result.color.size() == 1);
+    CHECK(!result.color.empty() && result.color[0].start == 0 && result.color[0].len == 3);
+    CHECK(!result.color.empty() && result.color[0].color.front == RED);
+    CHECK(!result.color.empty() && result.color[0].color.back == defaultAttr.color.back);
+    CHECK(parser.currentTextAttr().state == TextAttribute::State::CUSTOM);
+
+    // the attribute is kept across calls
+    result = parser.parse("bar\033[mbaz");
+    CHECK(result.text == "barbaz");
+    CHECK(result.color.size() == 2);
+    CHECK(result.color.size() == 2 && result.color[0].start == 0 && result.color[0].len == 3);
+    CHECK(result.color.size() == 2 && result.color[0].color.front == RED);
+    CHECK(result.color.size() == 2 && result.color[1].start == 3 && result.color[1].len == 3);
+    CHECK(result.color.size() == 2 && result.color[1].color == defaultAttr.color);
+    CHECK(parser.currentTextAttr() == defaultAttr);
+}
+
+// runs of a parser without coalescing, merged like coalescing does
+static std::vector<CompactRun> merged(const CompactText& text, const AttributeTable& table)
+{
+    std::vector<CompactRun> runs;
+    for (const auto& run : text.runs) {
+        if (run.len == 0) {
+            continue;
+        }
+        if (!runs.empty() && runs.back().start + runs.back().len == run.start
+            && table.resolve(runs.back().attrId) == table.resolve(run.attrId)) {
+            runs.back().len += run.len;
+            continue;
+        }
+        runs.push_back(run);
+    }
+    return runs;
+}
+
+static void testCoalesce(TextParser::Mode mode)
+{
+    TokenGenerator generator(20);
+    auto           lines = generator.lines(20000, 10);
+
+    AttributeTable rawTable;
+    AttributeTable table;
+    TextParser     raw(defaultAttr, defaultAttr);
+    TextParser     parser(defaultAttr, defaultAttr);
+    raw.enableCoalesce(false);
+    CHECK(parser.coalesce());
+
+    for (const auto& line : lines) {
+        auto rawText = raw.parse(line, rawTable, mode);
+        auto text    = parser.parse(line, table, mode);
+        auto expect  = merged(rawText, rawTable);
+        CHECK(text.text == rawText.text);
+        CHECK(text.runs.size() == expect.size());
+        if (text.runs.size() != expect.size()) {
+            continue;
+        }
+        for (size_t i = 0; i < expect.size(); ++i) {
+            const auto& run = text.runs[i];
+            CHECK(run.len != 0);
+            CHECK(run.start == expect[i].start && run.len == expect[i].len);
+            CHECK(table.resolve(run.attrId) == rawTable.resolve(expect[i].attrId));
+        }
+    }
+    CHECK(parser.currentTextAttr() == raw.currentTextAttr());
+}
+
+static void testCoalesceLiterals()
+{
+    TextParser parser(defaultAttr, defaultAttr);
+    TextParser raw(defaultAttr, defaultAttr);
+    raw.enableCoalesce(false);
+
+    auto result = parser.parse("\033[31mfoo\033[31mbar\033[32m\033[31mbaz");
+    CHECK(result.text == "foobarbaz");
+    CHECK(result.color.size() == 1 && result.color[0].start == 0 && result.color[0].len == 9);
+    CHECK(result.color.size() == 1 && result.color[0].color.front == RED);
+
+    result = raw.parse("\033[31mfoo\033[31mbar");
+    CHECK(result.color.size() == 2);
+    CHECK(result.color.size() == 2 && result.color[1].start == 3 && result.color[1].len == 3);
+
+    // an empty run between two sequences is dropped
+    TextParser fresh(defaultAttr, defaultAttr);
+    result = fresh.parse("a\033[32m\033[0mb");
+    CHECK(result.text == "ab" && result.color.size() == 1 && result.color[0].len == 2);
+}
+
+// a color set in the first line reaches the lines of every later chunk
+static void testParallelLiterals()
+{
+    std::vector<std::string> lines(4000, "x");
+    lines[0]    = "\033[31ma";
+    lines[2500] = "b\033[0mc";
+    for (size_t threadCnt : { 2, 3, 4, 7 }) {
+        TextParser parser(defaultAttr, defaultAttr);
+        auto       result = parser.parseParallel(lines, TextParser::Mode::ALL_TEXT, threadCnt);
+        CHECK(result.size() == lines.size());
+        if (result.size() != lines.size()) {
+            continue;
+        }
+        CHECK(result[1000].color.size() == 1 && result[1000].color[0].color.front == RED);
+        CHECK(result[2500].color.size() == 2 && result[2500].color[0].color.front == RED);
+        CHECK(result[2500].color.size() == 2 && result[2500].color[1].color == defaultAttr.color);
+        CHECK(result[3999].color.size() == 1 && result[3999].color[0].color == defaultAttr.color);
+        CHECK(parser.currentTextAttr() == defaultAttr);
+    }
+}
+
+static void testParallel(TextParser::Mode mode)
+{
+    TokenGenerator generator(21);
+    auto           lines = generator.lines(20000, 10);
+
+    for (size_t threadCnt : { 0, 1, 2, 4, 9 }) {
+        TextParser serial(defaultAttr, defaultAttr);
+        TextParser parallel(defaultAttr, defaultAttr);
+        auto       expect = serial.parse(lines, mode);
+        auto       result = parallel.parseParallel(lines, mode, threadCnt);
+        CHECK(result.size() == expect.size());
+        for (size_t i = 0; i < expect.size() && i < result.size(); ++i) {
+            ColorfulTextView view { result[i].text, result[i].color.data(), result[i].color.size() };
+            CHECK(sameRuns(view, expect[i]));
+        }
+        CHECK(parallel.currentTextAttr() == serial.currentTextAttr());
+    }
+}
+
+// visit, transform and parse share the scanner, so they agree on text and attributes
+static void testVisitTransform()
+{
+    struct Visitor {
+        std::string& text;
+        size_t&      changes;
+
+        void onText(std::string_view block, const TextAttribute&) { text.append(block); }
+
+        void onAttrChange(const TextAttribute&, const TextAttribute&) { ++changes; }
+    };
+
+    TokenGenerator generator(23);
+    TextParser     parser(defaultAttr, defaultAttr);
+    TextParser     visitParser(defaultAttr, defaultAttr);
+    size_t         changes = 0;
+    for (const auto& line : generator.lines(3000, 10)) {
+        auto before    = parser.currentTextAttr();
+        auto transform = parser.transform(line);
+        CHECK(parser.currentTextAttr() == before);
+
+        auto        expect = parser.parse(line);
+        std::string text;
+        visitParser.visit(line, Visitor { text, changes });
+        CHECK(text == expect.text);
+        CHECK(visitParser.currentTextAttr() == parser.currentTextAttr());
+        CHECK(transform.apply(before) == parser.currentTextAttr());
+    }
+    CHECK(changes > 0);
+}
+
+static void testPmr(TextParser::Mode mode)
+{
+    TokenGenerator generator(22);
+    auto           lines = generator.lines(2000, 10);
+
+    TextParser                          parser(defaultAttr, defaultAttr);
+    TextParser                          pmrParser(defaultAttr, defaultAttr);
+    std::pmr::monotonic_buffer_resource resource;
+    auto                                expect = parser.parse(lines, mode);
+    auto                                result = pmrParser.parse(lines, &resource, mode);
+    CHECK(result.size() == expect.size());
+    for (size_t i = 0; i < expect.size() && i < result.size(); ++i) {
+        ColorfulTextView view { result[i].text, result[i].color.data(), result[i].color.size() };
+        CHECK(sameRuns(view, expect[i]));
+    }
+}
+
+// all memory of the result comes from the resource
+static void testPmrLiterals()
+{
+    std::pmr::monotonic_buffer_resource resource;
+    TextParser                          parser(defaultAttr, defaultAttr);
+    auto                                result = parser.parse("\033[31mfoo\033[mbar", &resource);
+    CHECK(result.text == "foobar");
+    CHECK(result.color.size() == 2);
+    CHECK(result.color.size() == 2 && result.color[0].start == 0 && result.color[0].len == 3);
+    CHECK(result.color.size() == 2 && result.color[0].color.front == RED);
+    CHECK(result.color.size() == 2 && result.color[1].color == defaultAttr.color);
+    CHECK(result.text.get_allocator().resource() == &resource);
+    CHECK(result.color.get_allocator().resource() == &resource);
+
+    std::vector<std::string> lines { "a\033[31mb", "c" };
+    auto                     list = parser.parse(lines, &resource);
+    CHECK(list.get_allocator().resource() == &resource);
+    CHECK(list.size() == 2 && list[1].text == "c" && list[1].color.size() == 1 && list[1].color[0].color.front == RED);
+    CHECK(list.size() == 2 && list[1].text.get_allocator().resource() == &resource);
+}
+
+int main()
+{
+    testLiterals();
+    testParallelLiterals();
+    testVisitTransform();
+    testPmrLiterals();
+    testCoalesceLiterals();
+    for (auto mode : { TextParser::Mode::ALL_TEXT, TextParser::Mode::MARKED_TEXT }) {
+        testCoalesce(mode);
+        testParallel(mode);
+        testPmr(mode);
+    }
+    return testResult("text_parser_test");
+}
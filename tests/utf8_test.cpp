@@ -0,0 +1,172 @@
+//
+// Created by marvin on 26-10-17.
+//
+
+#include <cstring>
+
+#include "SIMD.h"
+#include "TextParser.h"
+#include "UTF8.h"
+#include "test_support.h"
+
+using namespace ANSI;
+
+static std::string encode(char32_t codePoint)
+{
+    std::string bytes;
+    if (codePoint < 0x80) {
+        bytes += char(codePoint);
+    }
+    else if (codePoint < 0x800) {
+        bytes += char(0xC0 | codePoint >> 6);
+        bytes += char(0x80 | (codePoint & 0x3F));
+    }
+    else if (codePoint < 0x10000) {
+        bytes += char(0xE0 | codePoint >> 12);
+        bytes += char(0x80 | (codePoint >> 6 & 0x3F));
+        bytes += char(0x80 | (codePoint & 0x3F));
+    }
+    else {
+        bytes += char(0xF0 | codePoint >> 18);
+        bytes += char(0x80 | (codePoint >> 12 & 0x3F));
+        bytes += char(0x80 | (codePoint >> 6 & 0x3F));
+        bytes += char(0x80 | (codePoint & 0x3F));
+    }
+    return bytes;
+}
+
+// every code point is decoded from its encoding
+static void testDecode()
+{
+    for (char32_t codePoint = 0; codePoint <= 0x10FFFF; ++codePoint) {
+        if (codePoint >= 0xD800 && codePoint <= 0xDFFF) {
+            continue;
+        }
+        auto        bytes = encode(codePoint);
+        const char* cur   = bytes.data();
+        CHECK(UTF8::decode(cur, bytes.data() + bytes.size()) == codePoint);
+        CHECK(cur == bytes.data() + bytes.size());
+    }
+}
+
+// an invalid, overlong, surrogate or cut sequence is one REPLACEMENT per byte
+static void testInvalid()
+{
+    const struct {
+        const char* bytes;
+        size_t      codePoints;
+    } cases[] {
+        { "\xC0\x80", 2 }, { "\xE0\x80\x80", 3 }, { "\xED\xA0\x80", 3 }, { "\xF4\x90\x80\x80", 4 },
+        { "\xE4\xB8", 2 }, { "\x80", 1 },         { "\xFF", 1 },         { "a\xE4\xB8" "b", 4 },
+    };
+    for (const auto& invalid : cases) {
+        auto width = UTF8::measure(invalid.bytes);
+        CHECK(width.codePoints == invalid.codePoints);
+        CHECK(width.columns == invalid.codePoints);
+    }
+
+    const char* bytes = "\xE4\xB8";
+    const char* cur   = bytes;
+    CHECK(UTF8::decode(cur, bytes + 2) == UTF8::REPLACEMENT);
+    CHECK(cur == bytes + 1);
+}
+
+static void testMeasure()
+{
+    auto width = UTF8::measure("\xE4\xB8\xAD\xE6\x96\x87" "abc\tx\xCC\x81\xF0\x9F\x98\x80");
+    CHECK(width.codePoints == 9);
+    CHECK(width.columns == 2 + 2 + 3 + 0 + 1 + 0 + 2);
+}
+
+// all SIMD levels find the same byte
+static void testSIMDLevels()
+{
+    TokenGenerator generator(80);
+    for (int i = 0; i < 20000; ++i) {
+        std::string text;
+        for (size_t len = generator.uniform(100); len != 0; --len) {
+            text += char(generator.uniform(8) != 0 ? 0x20 + generator.uniform(95) : generator.uniform(256));
+        }
+        const char* found[3];
+        for (int level = 0; level < 3; ++level) {
+            SIMD::setLevel(SIMD::Level(level));
+            found[level] = SIMD::findNonPrintableASCII(text.data(), text.data() + text.size());
+        }
+        CHECK(found[0] == found[1] && found[1] == found[2]);
+    }
+    SIMD::setLevel(SIMD::supportedLevel());
+}
+
+static void testColumnLiterals()
+{
+    TextParser parser(defaultAttr, defaultAttr);
+
+    // CJK and emoji take 2 columns, a combining mark none
+    auto columns = parser.parseColumns("\xE4\xB8\xAD\033[31m\xF0\x9F\x98\x80" "e\xCC\x81\033[0mab");
+    CHECK(columns.text == "\xE4\xB8\xAD\xF0\x9F\x98\x80" "e\xCC\x81" "ab");
+    CHECK(columns.columns.size() == 3);
+    if (columns.columns.size() == 3) {
+        const auto& cjk   = columns.columns[0];
+        const auto& emoji = columns.columns[1];
+        const auto& ascii = columns.columns[2];
+        CHECK(cjk.codePointStart == 0 && cjk.codePointLen == 1 && cjk.columnStart == 0 && cjk.columnLen == 2);
+        CHECK(emoji.codePointStart == 1 && emoji.codePointLen == 3 && emoji.columnStart == 2 && emoji.columnLen == 3);
+        CHECK(ascii.codePointStart == 4 && ascii.codePointLen == 2 && ascii.columnStart == 5 && ascii.columnLen == 2);
+    }
+
+    // a sequence which cuts a UTF-8 sequence ends it, also when the runs around it are merged
+    columns = parser.parseColumns("\xE4\033[K\xB8\xAD");
+    CHECK(columns.text == "\xE4\xB8\xAD");
+    CHECK(columns.columns.size() == 1);
+    CHECK(columns.columns.size() == 1 && columns.columns[0].codePointLen == 3 && columns.columns[0].columnLen == 3);
+}
+
+// parseColumns has the runs of parse, with their code points and columns measured by UTF8::measure
+static void testParseColumns(TextParser::Mode mode)
+{
+    TokenGenerator generator(81);
+    TextParser     parser(defaultAttr, defaultAttr);
+    TextParser     columnParser(defaultAttr, defaultAttr);
+    for (const auto& line : generator.lines(20000, 10)) {
+        auto text    = parser.parse(line, mode);
+        auto columns = columnParser.parseColumns(line, mode);
+        CHECK(columns.text == text.text);
+        CHECK(columns.color.size() == text.color.size() && columns.columns.size() == text.color.size());
+        if (columns.text != text.text || columns.color.size() != text.color.size()
+            || columns.columns.size() != text.color.size()) {
+            continue;
+        }
+
+        std::string_view view { columns.text };
+        for (size_t i = 0; i < text.color.size(); ++i) {
+            const auto& run = columns.color[i];
+            CHECK(run.start == text.color[i].start && run.len == text.color[i].len);
+            auto before = UTF8::measure(view.substr(0, run.start));
+            auto inside = UTF8::measure(view.substr(run.start, run.len));
+            CHECK(columns.columns[i].codePointStart == before.codePoints);
+            CHECK(columns.columns[i].columnStart == before.columns);
+            CHECK(columns.columns[i].codePointLen == inside.codePoints);
+            CHECK(columns.columns[i].columnLen == inside.columns);
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    // columns of every code point as one byte each, compared with unicodedata by utf8_widths.py
+    if (argc > 1 && std::strcmp(argv[1], "--widths") == 0) {
+        for (char32_t codePoint = 0; codePoint <= 0x10FFFF; ++codePoint) {
+            std::putchar(UTF8::columnsOf(codePoint));
+        }
+        return 0;
+    }
+
+    testDecode();
+    testInvalid();
+    testMeasure();
+    testSIMDLevels();
+    testColumnLiterals();
+    testParseColumns(TextParser::Mode::ALL_TEXT);
+    testParseColumns(TextParser::Mode::MARKED_TEXT);
+    return testResult("utf8_test");
+}
@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+#
+# Compare UTF8::columnsOf for every assigned code point with the unicodedata module of Python.
+#
+# usage: utf8_widths.py path/to/utf8_test
+#
+# The tables of UTF8.cpp are from Unicode 14.0, the test is skipped with exit code 77 for another version.
+
+import subprocess
+import sys
+import unicodedata
+
+SKIP = 77
+
+
+def expected_columns(code_point):
+    """wcwidth() of UTF8.h, None for a code point which is not assigned"""
+    char = chr(code_point)
+    category = unicodedata.category(char)
+    # unassigned code points of the CJK planes 2 and 3 are wide
+    if category == 'Cn' and not 0x20000 <= code_point <= 0x3FFFD:
+        return None
+    if category == 'Cs':
+        return None
+    if code_point < 0x20 or 0x7F <= code_point < 0xA0:
+        return 0
+    if category in ('Mn', 'Me', 'Cf') and code_point != 0xAD:
+        return 0
+    # Hangul Jungseong and Jongseong join the syllable before them
+    if 0x1160 <= code_point <= 0x11FF or 0xD7B0 <= code_point <= 0xD7FF:
+        return 0
+    if unicodedata.east_asian_width(char) in ('W', 'F'):
+        return 2
+    return 1
+
+
+def main():
+    if unicodedata.unidata_version != '14.0.0':
+        print('unicodedata is version %s, not 14.0.0, skip' % unicodedata.unidata_version)
+        return SKIP
+
+    widths = subprocess.run([sys.argv[1], '--widths'], stdout=subprocess.PIPE, check=True).stdout
+    if len(widths) != 0x110000:
+        print('expected 0x110000 widths, got %d' % len(widths))
+        return 1
+
+    failures = 0
+    for code_point in range(0x110000):
+        expect = expected_columns(code_point)
+        if expect is not None and widths[code_point] != expect:
+            if failures < 20:
+                print('U+%04X: columnsOf %d, expected %d' % (code_point, widths[code_point], expect))
+            failures += 1
+    print('utf8_widths: %s' % ('%d code points differ' % failures if failures else 'passed'))
+    return 1 if failures else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())